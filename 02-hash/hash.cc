@@ -1,14 +1,30 @@
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
+#include <variant>
+#include <climits>
+#include <limits>
+#include <memory>
+#include <iterator>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+#include <utility>
 #include <cassert>
+#include <cerrno>
 #include <iostream>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "hash.h"
+#include "sequence_set.h"
 
 namespace jnp1 {
-	using vi = std::vector<uint64_t>;
 	using std::unordered_map;
-	using std::unordered_set;
+	using std::vector;
 	using std::cerr;
 	
 	#ifdef NDEBUG
@@ -17,6 +33,9 @@ namespace jnp1 {
 		const bool debug = true;
 	#endif
 	
+	using details::sequence;
+	using details::mix_hash;
+	
 	class hasher {
 	private:
 		hash_function_t hash_function;
@@ -25,17 +44,1235 @@ namespace jnp1 {
 			hash_function = _hash_function;
 		}
 		
-		uint64_t operator()(const vi& vec) const {
-			assert(!vec.empty());
-			return hash_function(&vec[0], vec.size());
+		uint64_t operator()(uint64_t const *seq, size_t size) const {
+			return hash_function(seq, size);
+		}
+	};
+	
+	using hash_set = sequence_set<hasher>;
+	
+	// Compressed trie (radix tree) over uint64_t symbols. Sequences sharing a
+	// prefix share the nodes of that prefix; chains of nodes with a single
+	// child are merged into one edge labelled with the whole chain.
+	class trie {
+	private:
+		struct node {
+			sequence label;
+			bool terminal = false;
+			size_t count = 0;
+			vector<std::unique_ptr<node>> children;
+			
+			explicit node(sequence_view _label)
+				: label(_label.data, _label.size) {}
+			
+			node(const node &other)
+				: label(other.label), terminal(other.terminal),
+				  count(other.count) {
+				children.reserve(other.children.size());
+				for (const auto &child : other.children) {
+					children.push_back(std::make_unique<node>(*child));
+				}
+			}
+			
+			node(node &&other) = default;
+			
+			// Position of the child whose label starts with symbol, or of the
+			// place where such a child would be inserted.
+			size_t child_index(uint64_t symbol) const {
+				auto it = std::lower_bound(children.begin(), children.end(),
+				                           symbol,
+				                           [](const auto &child, uint64_t s) {
+					return child->label.data()[0] < s;
+				});
+				return it - children.begin();
+			}
+			
+			node *child(uint64_t symbol) const {
+				size_t i = child_index(symbol);
+				if (i < children.size() &&
+				    children[i]->label.data()[0] == symbol) {
+					return children[i].get();
+				}
+				return nullptr;
+			}
+		};
+		
+		node root{sequence_view{nullptr, 0}};
+		
+		static size_t common_length(const sequence &label, sequence_view seq,
+		                            size_t from) {
+			size_t length = std::min(label.size(), seq.size - from);
+			size_t i = 0;
+			while (i < length && label.data()[i] == seq[from + i]) {
+				i++;
+			}
+			return i;
+		}
+		
+		// Descends along seq. Returns the node reached after consuming all of
+		// seq, the path from the root to it, and whether the last edge was
+		// consumed only partially (only possible when partial is allowed).
+		node *descend(sequence_view seq, bool partial,
+		              vector<node *> *path) const {
+			node *current = const_cast<node *>(&root);
+			size_t i = 0;
+			while (i < seq.size) {
+				if (path != nullptr) {
+					path->push_back(current);
+				}
+				node *next = current->child(seq[i]);
+				if (next == nullptr) {
+					return nullptr;
+				}
+				size_t common = common_length(next->label, seq, i);
+				if (common < next->label.size() && i + common < seq.size) {
+					return nullptr;
+				}
+				if (common < next->label.size() && !partial) {
+					return nullptr;
+				}
+				current = next;
+				i += common;
+			}
+			return current;
+		}
+		
+		// Merges node with its only child, if it is not a sequence end.
+		static void compress(node &parent, size_t index) {
+			node &n = *parent.children[index];
+			if (n.terminal || n.children.size() != 1) {
+				return;
+			}
+			std::unique_ptr<node> child = std::move(n.children[0]);
+			vector<uint64_t> label(n.label.data(),
+			                       n.label.data() + n.label.size());
+			label.insert(label.end(), child->label.data(),
+			             child->label.data() + child->label.size());
+			child->label = sequence(label.data(), label.size());
+			parent.children[index] = std::move(child);
+		}
+		
+		template <typename Visitor>
+		static void visit_subtree(const node &n, vector<uint64_t> &buffer,
+		                          Visitor &visit) {
+			buffer.insert(buffer.end(), n.label.data(),
+			              n.label.data() + n.label.size());
+			if (n.terminal) {
+				visit(sequence_view{buffer.data(), buffer.size()});
+			}
+			for (const auto &child : n.children) {
+				visit_subtree(*child, buffer, visit);
+			}
+			buffer.resize(buffer.size() - n.label.size());
+		}
+		
+	public:
+		size_t size() const {
+			return root.count;
+		}
+		
+		void clear() {
+			root.children.clear();
+			root.count = 0;
+		}
+		
+		bool contains(sequence_view seq) const {
+			node *n = descend(seq, false, nullptr);
+			return n != nullptr && n->terminal;
+		}
+		
+		bool insert(sequence_view seq) {
+			if (contains(seq)) {
+				return false;
+			}
+			
+			node *current = &root;
+			size_t i = 0;
+			while (true) {
+				current->count++;
+				if (i == seq.size) {
+					current->terminal = true;
+					return true;
+				}
+				
+				size_t index = current->child_index(seq[i]);
+				if (index == current->children.size() ||
+				    current->children[index]->label.data()[0] != seq[i]) {
+					auto leaf = std::make_unique<node>(
+						sequence_view{seq.data + i, seq.size - i});
+					leaf->terminal = true;
+					leaf->count = 1;
+					current->children.insert(
+						current->children.begin() + index, std::move(leaf));
+					return true;
+				}
+				
+				std::unique_ptr<node> &next = current->children[index];
+				size_t common = common_length(next->label, seq, i);
+				if (common < next->label.size()) {
+					auto middle = std::make_unique<node>(
+						sequence_view{seq.data + i, common});
+					middle->count = next->count;
+					next->label = sequence(next->label.data() + common,
+					                       next->label.size() - common);
+					middle->children.push_back(std::move(next));
+					next = std::move(middle);
+				}
+				current = next.get();
+				i += common;
+			}
+		}
+		
+		bool remove(sequence_view seq) {
+			vector<node *> path;
+			node *n = descend(seq, false, &path);
+			if (n == nullptr || !n->terminal) {
+				return false;
+			}
+			
+			n->terminal = false;
+			n->count--;
+			for (node *ancestor : path) {
+				ancestor->count--;
+			}
+			
+			node &parent = *path.back();
+			size_t index = parent.child_index(n->label.data()[0]);
+			if (n->count == 0) {
+				parent.children.erase(parent.children.begin() + index);
+			}
+			else {
+				compress(parent, index);
+			}
+			if (path.size() > 1) {
+				node &grandparent = *path[path.size() - 2];
+				compress(grandparent,
+				         grandparent.child_index(parent.label.data()[0]));
+			}
+			return true;
+		}
+		
+		size_t prefix_count(sequence_view prefix) const {
+			node *n = descend(prefix, true, nullptr);
+			return n == nullptr ? 0 : n->count;
+		}
+		
+		template <typename Visitor>
+		void prefix_enumerate(sequence_view prefix, Visitor visit) const {
+			vector<node *> path;
+			node *n = descend(prefix, true, &path);
+			if (n == nullptr) {
+				return;
+			}
+			
+			vector<uint64_t> buffer;
+			for (size_t i = 1; i < path.size(); i++) {
+				buffer.insert(buffer.end(), path[i]->label.data(),
+				              path[i]->label.data() + path[i]->label.size());
+			}
+			visit_subtree(*n, buffer, visit);
+		}
+		
+		size_t partition_range() const {
+			return root.children.size();
+		}
+		
+		template <typename Visitor>
+		void for_each(size_t first, size_t last, Visitor visit) const {
+			vector<uint64_t> buffer;
+			for (size_t i = first; i < last; i++) {
+				visit_subtree(*root.children[i], buffer, visit);
+			}
+		}
+	};
+	
+	// Hash set kept in a named POSIX shared memory segment, so that several
+	// processes can attach to one copy. Writers are serialised by a process
+	// shared mutex stored in the segment. Readers take no lock: a slot is
+	// published with a release store of its state after its contents and the
+	// sequence are written, and a published slot never changes again, apart
+	// from being marked as removed. Slots and storage for sequences are
+	// allocated once, when the segment is created. Operations which move or
+	// reuse them, hash_clear and the compaction which reclaims removed
+	// sequences, bump a generation counter which readers check to retry.
+	//
+	// A writer may die holding the lock, which the next one to take it
+	// learns from the robust mutex. The segment is then rebuilt from the
+	// slots which are live, so a hash_clear or a compaction cut short
+	// leaves only some of the sequences, but the set is consistent again.
+	// Readers which find a rewrite going on for long take the lock too, so
+	// that they do not wait for a writer which is gone.
+	class shared_memory_set {
+	private:
+		static const uint64_t magic = 0x4a4e50314853484eULL;
+		
+		static const int attach_attempts = 1000;
+		
+		// Times a reader yields to a rewrite before it takes the lock.
+		static const int rewrite_patience = 1000;
+		
+		enum slot_state : uint64_t { empty = 0, live = 1, removed = 2 };
+		
+		struct header {
+			uint64_t magic;
+			std::atomic<uint64_t> ready;
+			pthread_mutex_t lock;
+			uint64_t slot_count;
+			uint64_t word_count;
+			std::atomic<uint64_t> generation;
+			std::atomic<uint64_t> size;
+			std::atomic<uint64_t> used_slots;
+			std::atomic<uint64_t> used_words;
+			std::atomic<uint64_t> removed_words;
+		};
+		
+		struct slot {
+			std::atomic<uint64_t> state;
+			std::atomic<uint64_t> hash;
+			std::atomic<uint64_t> length;
+			std::atomic<uint64_t> offset;
+		};
+		
+		hasher hash;
+		size_t bytes = 0;
+		header *head = nullptr;
+		slot *slots = nullptr;
+		std::atomic<uint64_t> *words = nullptr;
+		
+		// Size in bytes of a segment with the given numbers of slots and
+		// words, or false if it does not fit in size_t and off_t.
+		static bool segment_size(uint64_t slot_count, uint64_t word_count,
+		                         size_t &size) {
+			size_t slot_bytes, word_bytes;
+			return !__builtin_mul_overflow(slot_count, sizeof(slot),
+			                               &slot_bytes) &&
+			       !__builtin_mul_overflow(word_count, sizeof(uint64_t),
+			                               &word_bytes) &&
+			       !__builtin_add_overflow(sizeof(header), slot_bytes, &size) &&
+			       !__builtin_add_overflow(size, word_bytes, &size) &&
+			       size <= (size_t) std::numeric_limits<off_t>::max();
+		}
+		
+		// Number of slots for capacity sequences, a power of two, and size of
+		// the segment. False if either does not fit.
+		static bool layout(size_t capacity, size_t word_count,
+		                   uint64_t &slot_count, size_t &size) {
+			uint64_t needed;
+			if (__builtin_add_overflow(capacity, capacity / 3, &needed)) {
+				return false;
+			}
+			slot_count = 16;
+			while (slot_count < needed) {
+				if (slot_count > UINT64_MAX / 2) {
+					return false;
+				}
+				slot_count *= 2;
+			}
+			return segment_size(slot_count, word_count, size);
+		}
+		
+		void map(int fd, size_t size) {
+			void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			                     MAP_SHARED, fd, 0);
+			if (address == MAP_FAILED) {
+				return;
+			}
+			bytes = size;
+			head = static_cast<header *>(address);
+		}
+		
+		void locate() {
+			slots = reinterpret_cast<slot *>(head + 1);
+			words = reinterpret_cast<std::atomic<uint64_t> *>(
+				slots + head->slot_count);
+		}
+		
+		// On failure the segment is unlinked again, so that a later attempt
+		// does not find it half made.
+		void create(int fd, const char *name, size_t capacity,
+		            size_t word_count) {
+			uint64_t slot_count;
+			size_t size;
+			if (!layout(capacity, word_count, slot_count, size) ||
+			    ftruncate(fd, size) != 0) {
+				shm_unlink(name);
+				return;
+			}
+			map(fd, size);
+			if (head == nullptr) {
+				shm_unlink(name);
+				return;
+			}
+			
+			head->magic = magic;
+			head->slot_count = slot_count;
+			head->word_count = word_count;
+			pthread_mutexattr_t attributes;
+			pthread_mutexattr_init(&attributes);
+			pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+			pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+			pthread_mutex_init(&head->lock, &attributes);
+			pthread_mutexattr_destroy(&attributes);
+			locate();
+			head->ready.store(1, std::memory_order_release);
+		}
+		
+		// Waits for a creator in another process to finish, but only for
+		// attach_attempts milliseconds: a segment left behind by a creator
+		// which died is never finished.
+		void attach(int fd) {
+			struct stat status;
+			for (int attempt = 0; ; attempt++) {
+				if (fstat(fd, &status) != 0 || attempt == attach_attempts) {
+					return;
+				}
+				if (status.st_size >= (off_t) sizeof(header)) {
+					break;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			
+			map(fd, status.st_size);
+			if (head == nullptr) {
+				return;
+			}
+			for (int attempt = 0;
+			     head->ready.load(std::memory_order_acquire) == 0; attempt++) {
+				if (attempt == attach_attempts) {
+					munmap(head, bytes);
+					head = nullptr;
+					return;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			size_t size;
+			if (head->magic != magic || head->slot_count == 0 ||
+			    (head->slot_count & (head->slot_count - 1)) != 0 ||
+			    !segment_size(head->slot_count, head->word_count, size) ||
+			    bytes < size) {
+				munmap(head, bytes);
+				head = nullptr;
+				return;
+			}
+			locate();
+		}
+		
+		// The mutex is marked consistent only after the recovery, so that
+		// if this process dies in it too, the next one recovers again.
+		void lock() {
+			if (pthread_mutex_lock(&head->lock) == EOWNERDEAD) {
+				recover();
+				pthread_mutex_consistent(&head->lock);
+			}
+		}
+		
+		void unlock() {
+			pthread_mutex_unlock(&head->lock);
+		}
+		
+		// Whether a sequence read from a slot lies within the storage. A
+		// reader racing with hash_clear or a compaction in another process
+		// may see offset and length of different sequences.
+		bool in_storage(uint64_t offset, uint64_t length) const {
+			return length <= head->word_count &&
+			       offset <= head->word_count - length;
+		}
+		
+		bool equal(const slot &s, uint64_t h, sequence_view seq) const {
+			if (s.hash.load(std::memory_order_relaxed) != h ||
+			    s.length.load(std::memory_order_relaxed) != seq.size) {
+				return false;
+			}
+			uint64_t offset = s.offset.load(std::memory_order_relaxed);
+			if (!in_storage(offset, seq.size)) {
+				return false;
+			}
+			for (size_t i = 0; i < seq.size; i++) {
+				if (words[offset + i].load(std::memory_order_relaxed) !=
+				    seq[i]) {
+					return false;
+				}
+			}
+			return true;
+		}
+		
+		// Index of the live slot holding seq, or slot_count if there is none.
+		uint64_t find(uint64_t h, sequence_view seq) const {
+			uint64_t mask = head->slot_count - 1;
+			for (uint64_t i = 0, index = h & mask; i <= mask;
+			     i++, index = (index + 1) & mask) {
+				uint64_t state = slots[index].state.load(
+					std::memory_order_acquire);
+				if (state == empty) {
+					break;
+				}
+				if (state == live && equal(slots[index], h, seq)) {
+					return index;
+				}
+			}
+			return head->slot_count;
+		}
+		
+		// Writers call these around changes which move published slots.
+		void begin_rewrite() {
+			uint64_t generation = head->generation.load(
+				std::memory_order_relaxed);
+			head->generation.store(generation + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+		
+		void end_rewrite() {
+			uint64_t generation = head->generation.load(
+				std::memory_order_relaxed);
+			head->generation.store(generation + 1, std::memory_order_release);
+		}
+		
+		bool has_room(uint64_t length) const {
+			return 4 * (head->used_slots.load(std::memory_order_relaxed) + 1)
+			       <= 3 * head->slot_count &&
+			       length <= head->word_count -
+			                 head->used_words.load(std::memory_order_relaxed);
+		}
+		
+		// Puts a sequence in a free slot and at the end of the used storage.
+		// The caller checks that there is room for it.
+		void place(uint64_t h, const uint64_t *seq, uint64_t length) {
+			uint64_t mask = head->slot_count - 1;
+			uint64_t index = h & mask;
+			while (slots[index].state.load(std::memory_order_relaxed) !=
+			       empty) {
+				index = (index + 1) & mask;
+			}
+			uint64_t used_words = head->used_words.load(
+				std::memory_order_relaxed);
+			for (size_t i = 0; i < length; i++) {
+				words[used_words + i].store(seq[i],
+				                            std::memory_order_relaxed);
+			}
+			slots[index].hash.store(h, std::memory_order_relaxed);
+			slots[index].length.store(length, std::memory_order_relaxed);
+			slots[index].offset.store(used_words, std::memory_order_relaxed);
+			slots[index].state.store(live, std::memory_order_release);
+			
+			head->used_slots.fetch_add(1, std::memory_order_relaxed);
+			head->used_words.store(used_words + length,
+			                       std::memory_order_relaxed);
+		}
+		
+		// Whether removed sequences hold enough slots or storage to be worth
+		// reclaiming. Compacting as soon as there is any would make every
+		// insert into a nearly full segment copy all of it.
+		bool worth_compacting() const {
+			uint64_t used_slots = head->used_slots.load(
+				std::memory_order_relaxed);
+			uint64_t removed_slots =
+				used_slots - head->size.load(std::memory_order_relaxed);
+			return 8 * removed_slots >= used_slots ||
+			       8 * head->removed_words.load(std::memory_order_relaxed) >=
+			       head->used_words.load(std::memory_order_relaxed);
+		}
+		
+		// Copies out the live sequences. Those of a slot whose sequence does
+		// not lie within the storage are skipped, which only happens after
+		// a writer died.
+		void collect(vector<uint64_t> &hashes, vector<uint64_t> &lengths,
+		             vector<uint64_t> &contents) const {
+			for (uint64_t i = 0; i < head->slot_count; i++) {
+				if (slots[i].state.load(std::memory_order_relaxed) != live) {
+					continue;
+				}
+				uint64_t length = slots[i].length.load(
+					std::memory_order_relaxed);
+				uint64_t offset = slots[i].offset.load(
+					std::memory_order_relaxed);
+				if (!in_storage(offset, length)) {
+					continue;
+				}
+				hashes.push_back(slots[i].hash.load(
+					std::memory_order_relaxed));
+				lengths.push_back(length);
+				for (uint64_t j = 0; j < length; j++) {
+					contents.push_back(words[offset + j].load(
+						std::memory_order_relaxed));
+				}
+			}
+		}
+		
+		// Empties the segment and puts the collected sequences back, as
+		// many as fit, which is all of them unless a writer died. Called
+		// during a rewrite.
+		void refill(const vector<uint64_t> &hashes,
+		            const vector<uint64_t> &lengths,
+		            const vector<uint64_t> &contents) {
+			for (uint64_t i = 0; i < head->slot_count; i++) {
+				slots[i].state.store(empty, std::memory_order_relaxed);
+			}
+			head->used_slots.store(0, std::memory_order_relaxed);
+			head->used_words.store(0, std::memory_order_relaxed);
+			head->removed_words.store(0, std::memory_order_relaxed);
+			const uint64_t *seq = contents.data();
+			uint64_t placed = 0;
+			for (size_t i = 0; i < hashes.size(); i++) {
+				if (has_room(lengths[i])) {
+					place(hashes[i], seq, lengths[i]);
+					placed++;
+				}
+				seq += lengths[i];
+			}
+			head->size.store(placed, std::memory_order_relaxed);
+		}
+		
+		// Rebuilds the slots and storage from the live sequences only, so
+		// that those of removed ones can be used again. Called with the lock
+		// held.
+		void compact() {
+			vector<uint64_t> hashes, lengths, contents;
+			collect(hashes, lengths, contents);
+			begin_rewrite();
+			refill(hashes, lengths, contents);
+			end_rewrite();
+		}
+		
+		// Called with the lock taken over from a writer which died. It may
+		// have been in a rewrite, so the generation is made odd instead of
+		// incremented, and it may have left the counts behind the slots,
+		// so these are all rebuilt.
+		void recover() {
+			uint64_t generation = head->generation.load(
+				std::memory_order_relaxed);
+			head->generation.store(generation | 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			vector<uint64_t> hashes, lengths, contents;
+			collect(hashes, lengths, contents);
+			refill(hashes, lengths, contents);
+			end_rewrite();
+		}
+		
+		// Called by a reader which has seen the same rewrite for long: it
+		// ends once the lock can be taken, and if its writer died, taking the
+		// lock recovers the segment. The segment is not part of the object,
+		// so this is const in all but name.
+		void wait_for_rewrite(int &yields) const {
+			if (++yields % rewrite_patience != 0) {
+				std::this_thread::yield();
+				return;
+			}
+			auto *self = const_cast<shared_memory_set *>(this);
+			self->lock();
+			self->unlock();
+		}
+		
+	public:
+		static bool valid_size(size_t capacity, size_t word_count) {
+			uint64_t slot_count;
+			size_t size;
+			return layout(capacity, word_count, slot_count, size);
+		}
+		
+		shared_memory_set(hasher _hash, const char *name, size_t capacity,
+		                  size_t word_count) : hash(_hash) {
+			int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+			if (fd != -1) {
+				create(fd, name, capacity, word_count);
+			}
+			else if (errno == EEXIST &&
+			         (fd = shm_open(name, O_RDWR, 0600)) != -1) {
+				attach(fd);
+			}
+			if (fd != -1) {
+				close(fd);
+			}
+		}
+		
+		shared_memory_set(const shared_memory_set &) = delete;
+		
+		~shared_memory_set() {
+			if (head != nullptr) {
+				munmap(head, bytes);
+			}
+		}
+		
+		bool attached() const {
+			return head != nullptr;
+		}
+		
+		const hasher &hash_function() const {
+			return hash;
+		}
+		
+		size_t size() const {
+			return head->size.load(std::memory_order_acquire);
+		}
+		
+		void clear() {
+			lock();
+			begin_rewrite();
+			for (uint64_t i = 0; i < head->slot_count; i++) {
+				slots[i].state.store(empty, std::memory_order_relaxed);
+			}
+			head->size.store(0, std::memory_order_relaxed);
+			head->used_slots.store(0, std::memory_order_relaxed);
+			head->used_words.store(0, std::memory_order_relaxed);
+			head->removed_words.store(0, std::memory_order_relaxed);
+			end_rewrite();
+			unlock();
+		}
+		
+		bool contains(sequence_view seq) const {
+			uint64_t h = hash(seq.data, seq.size);
+			int yields = 0;
+			while (true) {
+				uint64_t generation = head->generation.load(
+					std::memory_order_acquire);
+				if (generation % 2 == 1) {
+					wait_for_rewrite(yields);
+					continue;
+				}
+				bool found = find(h, seq) != head->slot_count;
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (head->generation.load(std::memory_order_relaxed) ==
+				    generation) {
+					return found;
+				}
+			}
+		}
+		
+		// Fails also if the segment has no free slot or storage left, even
+		// after reclaiming those of removed sequences.
+		bool insert(sequence_view seq) {
+			uint64_t h = hash(seq.data, seq.size);
+			lock();
+			if (find(h, seq) != head->slot_count) {
+				unlock();
+				return false;
+			}
+			if (!has_room(seq.size) && worth_compacting()) {
+				compact();
+			}
+			if (!has_room(seq.size)) {
+				unlock();
+				return false;
+			}
+			place(h, seq.data, seq.size);
+			head->size.fetch_add(1, std::memory_order_release);
+			unlock();
+			return true;
+		}
+		
+		bool remove(sequence_view seq) {
+			uint64_t h = hash(seq.data, seq.size);
+			lock();
+			uint64_t index = find(h, seq);
+			if (index == head->slot_count) {
+				unlock();
+				return false;
+			}
+			slots[index].state.store(removed, std::memory_order_release);
+			head->removed_words.fetch_add(
+				slots[index].length.load(std::memory_order_relaxed),
+				std::memory_order_relaxed);
+			head->size.fetch_sub(1, std::memory_order_release);
+			unlock();
+			return true;
+		}
+		
+		size_t partition_range() const {
+			return head->slot_count;
+		}
+		
+		// The sequences are copied out first and visited only once the copy
+		// is known not to have raced with a hash_clear or a compaction in
+		// another process.
+		template <typename Visitor>
+		void for_each(size_t first, size_t last, Visitor visit) const {
+			vector<uint64_t> lengths, contents;
+			int yields = 0;
+			while (true) {
+				uint64_t generation = head->generation.load(
+					std::memory_order_acquire);
+				if (generation % 2 == 1) {
+					wait_for_rewrite(yields);
+					continue;
+				}
+				lengths.clear();
+				contents.clear();
+				for (size_t index = first; index < last; index++) {
+					const slot &s = slots[index];
+					if (s.state.load(std::memory_order_acquire) != live) {
+						continue;
+					}
+					uint64_t length = s.length.load(std::memory_order_relaxed);
+					uint64_t offset = s.offset.load(std::memory_order_relaxed);
+					if (!in_storage(offset, length)) {
+						break;
+					}
+					lengths.push_back(length);
+					for (size_t i = 0; i < length; i++) {
+						contents.push_back(words[offset + i].load(
+							std::memory_order_relaxed));
+					}
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (head->generation.load(std::memory_order_relaxed) ==
+				    generation) {
+					break;
+				}
+			}
+			
+			const uint64_t *seq = contents.data();
+			for (uint64_t length : lengths) {
+				visit(sequence_view{seq, length});
+				seq += length;
+			}
+		}
+	};
+	
+	// Blocked Bloom filter. Every sequence sets one bit in each of the eight
+	// words of a single 64-byte block, so a lookup reads one cache line.
+	class bloom_filter {
+	private:
+		struct alignas(64) block {
+			uint64_t words[8] = {};
+		};
+		
+		static const size_t bits_per_element = 12;
+		
+		static constexpr uint32_t salts[8] = {
+			0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+			0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+		};
+		
+		vector<block> blocks;
+		size_t capacity;
+		size_t removed = 0;
+		
+		size_t block_index(uint64_t h) const {
+			return (h >> 32) & (blocks.size() - 1);
+		}
+		
+		static uint64_t mask(uint64_t h, size_t word) {
+			return uint64_t(1) << ((uint32_t(h) * salts[word]) >> 26);
+		}
+		
+	public:
+		// Sized for up to _capacity sequences.
+		explicit bloom_filter(size_t _capacity) : capacity(_capacity) {
+			size_t count = 1;
+			while (count * sizeof(block) * 8 < capacity * bits_per_element) {
+				count *= 2;
+			}
+			blocks.resize(count);
+		}
+		
+		void add(sequence_view seq) {
+			uint64_t h = mix_hash(seq);
+			block &b = blocks[block_index(h)];
+			for (size_t word = 0; word < 8; word++) {
+				b.words[word] |= mask(h, word);
+			}
+		}
+		
+		bool may_contain(sequence_view seq) const {
+			uint64_t h = mix_hash(seq);
+			const block &b = blocks[block_index(h)];
+			bool ans = true;
+			for (size_t word = 0; word < 8; word++) {
+				ans &= (b.words[word] & mask(h, word)) != 0;
+			}
+			return ans;
+		}
+		
+		void note_removal() {
+			removed++;
+		}
+		
+		// A filter is stale once it holds more sequences than it was sized
+		// for, or once so many were removed that its false positive rate is
+		// mostly made up of sequences which are gone.
+		bool stale(size_t size) const {
+			return size > capacity || removed > size;
+		}
+	};
+	
+	// Hash table of the module, kept either in a hash set or in a trie.
+	class table {
+	private:
+		using shared_set = std::shared_ptr<shared_memory_set>;
+		
+		// A trie is shared between copies of the table as a whole and copied
+		// on the first write, a hash_set shares its shards. A table in
+		// shared memory is never copied, its copies are all attached to the
+		// same segment.
+		std::variant<hash_set, std::shared_ptr<trie>, shared_set> storage;
+		std::shared_ptr<bloom_filter> filter;
+		
+		// Calls function on the storage, whichever kind it is.
+		template <typename Function>
+		decltype(auto) read(Function function) const {
+			return std::visit([&](const auto &s) -> decltype(auto) {
+				if constexpr (std::is_same_v<std::decay_t<decltype(s)>,
+				                             hash_set>) {
+					return function(s);
+				}
+				else {
+					return function(*s);
+				}
+			}, storage);
+		}
+		
+		const trie *tree() const {
+			auto *tree = std::get_if<std::shared_ptr<trie>>(&storage);
+			return tree == nullptr ? nullptr : tree->get();
+		}
+		
+		trie &writable_tree() {
+			auto &tree = std::get<std::shared_ptr<trie>>(storage);
+			if (tree.use_count() > 1) {
+				tree = std::make_shared<trie>(*tree);
+			}
+			return *tree;
+		}
+		
+		bloom_filter &writable_filter() {
+			if (filter.use_count() > 1) {
+				filter = std::make_shared<bloom_filter>(*filter);
+			}
+			return *filter;
+		}
+		
+		void rebuild_filter() {
+			auto fresh = std::make_shared<bloom_filter>(
+				std::max<size_t>(2 * size(), 1024));
+			for_each(0, partition_range(), [&](sequence_view seq) {
+				fresh->add(seq);
+			});
+			filter = std::move(fresh);
+		}
+		
+	public:
+		explicit table(hash_function_t hash_function)
+			: storage(std::in_place_type<hash_set>, hasher(hash_function)) {}
+		
+		explicit table(trie &&tree)
+			: storage(std::make_shared<trie>(std::move(tree))) {}
+		
+		explicit table(shared_set &&set) : storage(std::move(set)) {}
+		
+		template <typename... Args>
+		explicit table(std::in_place_type_t<hash_set> type, Args &&... args)
+			: storage(type, std::forward<Args>(args)...) {}
+		
+		// Copy of the table which does not change with it. Tables in shared
+		// memory are copied into a private hash table.
+		table snapshot() const {
+			auto *shared = std::get_if<shared_set>(&storage);
+			if (shared == nullptr) {
+				return *this;
+			}
+			
+			table ans(std::in_place_type<hash_set>,
+			          (*shared)->hash_function());
+			ans.reserve(size());
+			for_each(0, partition_range(), [&](sequence_view seq) {
+				ans.insert(seq);
+			});
+			return ans;
+		}
+		
+		size_t size() const {
+			return read([](const auto &s) { return s.size(); });
+		}
+		
+		void clear() {
+			if (auto *set = std::get_if<hash_set>(&storage)) {
+				set->clear();
+			}
+			else if (auto *shared = std::get_if<shared_set>(&storage)) {
+				(*shared)->clear();
+			}
+			else {
+				storage = std::make_shared<trie>();
+			}
+			if (filter != nullptr) {
+				rebuild_filter();
+			}
+		}
+		
+		void reserve(size_t size) {
+			if (auto *set = std::get_if<hash_set>(&storage)) {
+				set->reserve(size);
+			}
+		}
+		
+		// A table in shared memory cannot be filtered, as other processes
+		// would not update the filter.
+		bool set_filter(bool enabled) {
+			if (!enabled) {
+				filter.reset();
+			}
+			else if (std::holds_alternative<shared_set>(storage)) {
+				return false;
+			}
+			else if (filter == nullptr) {
+				rebuild_filter();
+			}
+			return true;
+		}
+		
+		// Rebuilds the filter if it became stale. Done lazily, before lookups,
+		// and not in contains, which may run on several threads at once.
+		void refresh_filter() {
+			if (filter != nullptr && filter->stale(size())) {
+				rebuild_filter();
+			}
+		}
+		
+		bool contains(sequence_view seq) const {
+			if (filter != nullptr && !filter->stale(size()) &&
+			    !filter->may_contain(seq)) {
+				return false;
+			}
+			return read([&](const auto &s) { return s.contains(seq); });
+		}
+		
+		bool insert(sequence_view seq) {
+			if (auto *set = std::get_if<hash_set>(&storage)) {
+				if (!set->insert(seq)) {
+					return false;
+				}
+			}
+			else if (auto *shared = std::get_if<shared_set>(&storage)) {
+				return (*shared)->insert(seq);
+			}
+			else {
+				if (tree()->contains(seq)) {
+					return false;
+				}
+				writable_tree().insert(seq);
+			}
+			if (filter != nullptr) {
+				writable_filter().add(seq);
+			}
+			return true;
+		}
+		
+		bool remove(sequence_view seq) {
+			if (auto *set = std::get_if<hash_set>(&storage)) {
+				if (!set->remove(seq)) {
+					return false;
+				}
+			}
+			else if (auto *shared = std::get_if<shared_set>(&storage)) {
+				return (*shared)->remove(seq);
+			}
+			else {
+				if (!tree()->contains(seq)) {
+					return false;
+				}
+				writable_tree().remove(seq);
+			}
+			if (filter != nullptr) {
+				writable_filter().note_removal();
+			}
+			return true;
+		}
+		
+		// The sequences are split into partition_range() slices, for_each
+		// visits the slices [first, last). Slices of a hash table are its
+		// shards, slices of a trie are the subtrees of the root, slices of a
+		// table in shared memory are its slots.
+		size_t partition_range() const {
+			return read([](const auto &s) { return s.partition_range(); });
+		}
+		
+		template <typename Visitor>
+		void for_each(size_t first, size_t last, Visitor visit) const {
+			read([&](const auto &s) { s.for_each(first, last, visit); });
+		}
+		
+		template <typename Visitor>
+		void prefix_enumerate(sequence_view prefix, Visitor visit) const {
+			if (const trie *t = tree()) {
+				t->prefix_enumerate(prefix, visit);
+				return;
+			}
+			for_each(0, partition_range(), [&](sequence_view seq) {
+				if (seq.size >= prefix.size &&
+				    std::equal(prefix.data, prefix.data + prefix.size,
+				               seq.data)) {
+					visit(seq);
+				}
+			});
+		}
+		
+		size_t prefix_count(sequence_view prefix) const {
+			if (const trie *t = tree()) {
+				return t->prefix_count(prefix);
+			}
+			size_t count = 0;
+			prefix_enumerate(prefix, [&](sequence_view) { count++; });
+			return count;
 		}
 	};
 	
-	unordered_map<unsigned long, unordered_set<vi, hasher>> &hash_tables() {
-		static unordered_map<unsigned long, unordered_set<vi, hasher>> ans;
+	unordered_map<unsigned long, table> &hash_tables() {
+		static unordered_map<unsigned long, table> ans;
+		return ans;
+	}
+	
+	const size_t min_partition_size = 1 << 14;
+	
+	// Id which is never given to a table, returned where there is no table to
+	// give an id of.
+	const unsigned long no_table = ULONG_MAX;
+	
+	table *find_table(unsigned long id) {
+		auto it = hash_tables().find(id);
+		return it == hash_tables().end() ? nullptr : &it->second;
+	}
+	
+	unsigned long new_table(table &&tab) {
+		static unsigned long last_id = 0;
+		hash_tables().emplace(last_id, std::move(tab));
+		return last_id++;
+	}
+	
+	size_t partitions(const table &tab) {
+		size_t threads = std::max(1u, std::thread::hardware_concurrency());
+		return std::min(threads, tab.size() / min_partition_size + 1);
+	}
+	
+	// Calls function(part, visitor) for every partition of the sequences of
+	// tab, each partition on its own thread. The function is expected to pass
+	// a visitor to tab.for_each through the given callback.
+	template <typename Function>
+	void for_each_partition(const table &tab, Function function) {
+		size_t parts = partitions(tab);
+		size_t range = tab.partition_range();
+		auto run = [&](size_t part) {
+			function(part, [&](auto visit) {
+				tab.for_each(range * part / parts, range * (part + 1) / parts,
+				             visit);
+			});
+		};
+		if (parts == 1) {
+			run(0);
+			return;
+		}
+		
+		vector<std::thread> workers;
+		for (size_t part = 0; part < parts; part++) {
+			workers.emplace_back(run, part);
+		}
+		for (std::thread &worker : workers) {
+			worker.join();
+		}
+	}
+	
+	// Returns the sequences of from which are (keep_present) or are not
+	// (!keep_present) contained in other. A missing table is empty.
+	vector<sequence> filter(const table *from, const table *other,
+	                        bool keep_present) {
+		if (from == nullptr) {
+			return {};
+		}
+		
+		vector<vector<sequence>> found(partitions(*from));
+		for_each_partition(*from, [&](size_t part, auto for_each) {
+			for_each([&](sequence_view seq) {
+				bool present = other != nullptr && other->contains(seq);
+				if (present == keep_present) {
+					found[part].emplace_back(seq.data, seq.size);
+				}
+			});
+		});
+		
+		vector<sequence> ans;
+		for (vector<sequence> &part : found) {
+			std::move(part.begin(), part.end(), std::back_inserter(ans));
+		}
+		return ans;
+	}
+	
+	size_t common_size(const table *a, const table *b) {
+		if (a == nullptr || b == nullptr) {
+			return 0;
+		}
+		if (a->size() > b->size()) {
+			std::swap(a, b);
+		}
+		
+		vector<size_t> counts(partitions(*a), 0);
+		for_each_partition(*a, [&](size_t part, auto for_each) {
+			size_t count = 0;
+			for_each([&](sequence_view seq) {
+				count += b->contains(seq);
+			});
+			counts[part] = count;
+		});
+		
+		size_t ans = 0;
+		for (size_t count : counts) {
+			ans += count;
+		}
 		return ans;
 	}
 	
+	unsigned long fill_table(hash_function_t hash_function,
+	                         const vector<sequence> &first,
+	                         const vector<sequence> &second) {
+		unsigned long id = new_table(table(hash_function));
+		table &tab = *find_table(id);
+		tab.reserve(first.size() + second.size());
+		for (const vector<sequence> *part : {&first, &second}) {
+			for (const sequence &seq : *part) {
+				tab.insert(seq.view());
+			}
+		}
+		return id;
+	}
+	
+	// Also brings the filters of both tables up to date, so that the lookups
+	// done in parallel by the set operation can use them.
+	void prepare_set_operation(const char *name, unsigned long id1,
+	                           unsigned long id2) {
+		if (debug) {
+			cerr << name << "(" << id1 << ", " << id2 << ")\n";
+		}
+		for (unsigned long id : {id1, id2}) {
+			table *tab = find_table(id);
+			if (tab != nullptr) {
+				tab->refresh_filter();
+			}
+			else if (debug) {
+				cerr << name << ": hash table #" << id << " does not exist\n";
+			}
+		}
+	}
+	
+	void print_set_result(const char *name, unsigned long id) {
+		if (debug) {
+			cerr << name << ": hash table #" << id << " created with "
+			     << find_table(id)->size() << " element(s)\n";
+		}
+	}
+	
+	void print_sequence(uint64_t const *seq, size_t size) {
+		if (seq != nullptr) {
+			cerr << "\"";
+			if (size > 0) {
+				for (size_t i = 0; i < size - 1; i++) {
+					cerr << seq[i] << " ";
+				}
+				cerr << seq[size - 1];
+			}
+			cerr << "\"";
+		}
+		else {
+			cerr << "NULL";
+		}
+	}
+	
 	void print_start() {
 		if (debug) {
 			static std::ios_base::Init init;
@@ -45,16 +1282,14 @@ namespace jnp1 {
 	unsigned long hash_create(hash_function_t hash_function) {
 		print_start();
 		
-		unordered_set<vi, hasher> uset(16, hasher(hash_function));
-		static unsigned long last_id = 0;
-		hash_tables().emplace(last_id, uset);
+		unsigned long id = new_table(table(hash_function));
 		
 		if (debug) {
 			cerr << "hash_create(" << &hash_function << ")\n";
-			cerr << "hash_create: hash table #" << last_id << " created\n";
+			cerr << "hash_create: hash table #" << id << " created\n";
 		}
 		
-		return last_id++;
+		return id;
 	}
 	
 	void hash_delete(unsigned long id) {
@@ -102,19 +1337,7 @@ namespace jnp1 {
 		
 		if (debug) {
 			cerr << "hash_insert(" << id << ", ";
-			if (seq != nullptr) {
-				cerr << "\"";
-				if (size > 0) {
-					for (size_t i = 0; i < size - 1; i++) {
-						cerr << seq[i] << " ";
-					}
-					cerr << seq[size - 1];
-				}
-				cerr << "\"";
-			}
-			else {
-				cerr << "NULL";
-			}
+			print_sequence(seq, size);
 			cerr << ", " << size << ")\n";
 		}
 		
@@ -146,23 +1369,21 @@ namespace jnp1 {
 			return false;
 		}
 		
-		vi vec(seq, seq + size);
+		sequence_view vec{seq, size};
 		if (debug) {
-			cerr << ", sequence \"";
-			for (size_t i = 0; i < size - 1; i++) {
-				cerr << vec[i] << " ";
-			}
-			cerr << vec[size - 1] << "\" ";
+			cerr << ", sequence ";
+			print_sequence(seq, size);
+			cerr << " ";
 		}
 		
-		unordered_set<vi, hasher>& uset = hash_tables().find(id)->second;
-		if (uset.find(vec) != uset.end()) {
+		table& tab = hash_tables().find(id)->second;
+		if (!tab.insert(vec)) {
 			if (debug) {
-				cerr << "was present\n";
+				cerr << (tab.contains(vec) ? "was present\n"
+				                           : "not inserted, table is full\n");
 			}
 			return false;
 		}
-		uset.insert(vec);
 		if (debug) {
 			cerr << "inserted\n";
 		}
@@ -175,19 +1396,7 @@ namespace jnp1 {
 		
 		if (debug) {
 			cerr << "hash_remove(" << id << ", ";
-			if (seq != nullptr) {
-				cerr << "\"";
-				if (size > 0) {
-					for (size_t i = 0; i < size - 1; i++) {
-						cerr << seq[i] << " ";
-					}
-					cerr << seq[size - 1];
-				}
-				cerr << "\"";
-			}
-			else {
-				cerr << "NULL";
-			}
+			print_sequence(seq, size);
 			cerr << ", " << size << ")\n";
 		}
 		
@@ -219,23 +1428,20 @@ namespace jnp1 {
 			return false;
 		}
 		
-		vi vec(seq, seq + size);
+		sequence_view vec{seq, size};
 		if (debug) {
-			cerr << ", sequence \"";
-			for (size_t i = 0; i < size - 1; i++) {
-				cerr << vec[i] << " ";
-			}
-			cerr << vec[size - 1] << "\" ";
+			cerr << ", sequence ";
+			print_sequence(seq, size);
+			cerr << " ";
 		}
 		
-		unordered_set<vi, hasher>& uset = hash_tables().find(id)->second;
-		if (uset.find(vec) == uset.end()) {
+		table& tab = hash_tables().find(id)->second;
+		if (!tab.remove(vec)) {
 			if (debug) {
 				cerr << "was not present\n";
 			}
 			return false;
 		}
-		uset.erase(vec);
 		if (debug) {
 			cerr << "removed\n";
 		}
@@ -251,11 +1457,11 @@ namespace jnp1 {
 			cerr << "hash_clear: hash table #" << id;
 		}
 		if (hash_tables().find(id) != hash_tables().end()) {
-			unordered_set<vi, hasher>& uset = hash_tables().find(id)->second;
+			table& tab = hash_tables().find(id)->second;
 			if (debug) {
-				cerr << (uset.empty() ? " was empty\n" : " cleared\n");
+				cerr << (tab.size() == 0 ? " was empty\n" : " cleared\n");
 			}
-			uset.clear();
+			tab.clear();
 		}
 		else if (debug) {
 			cerr << " does not exist\n";
@@ -267,19 +1473,7 @@ namespace jnp1 {
 		
 		if (debug) {
 			cerr << "hash_test(" << id << ", ";
-			if (seq != nullptr) {
-				cerr << "\"";
-				if (size > 0) {
-					for (size_t i = 0; i < size - 1; i++) {
-						cerr << seq[i] << " ";
-					}
-					cerr << seq[size - 1];
-				}
-				cerr << "\"";
-			}
-			else {
-				cerr << "NULL";
-			}
+			print_sequence(seq, size);
 			cerr << ", " << size << ")\n";
 		}
 		
@@ -311,17 +1505,16 @@ namespace jnp1 {
 			return false;
 		}
 		
-		vi vec(seq, seq + size);
+		sequence_view vec{seq, size};
 		if (debug) {
-			cerr << ", sequence \"";
-			for (size_t i = 0; i < size - 1; i++) {
-				cerr << vec[i] << " ";
-			}
-			cerr << vec[size - 1] << "\" ";
+			cerr << ", sequence ";
+			print_sequence(seq, size);
+			cerr << " ";
 		}
 		
-		unordered_set<vi, hasher>& uset = hash_tables().find(id)->second;
-		if (uset.find(vec) == uset.end()) {
+		table& tab = hash_tables().find(id)->second;
+		tab.refresh_filter();
+		if (!tab.contains(vec)) {
 			if (debug) {
 				cerr << "is not present\n";
 			}
@@ -334,4 +1527,287 @@ namespace jnp1 {
 			return true;
 		}
 	}
+	
+	unsigned long hash_create_trie(void) {
+		print_start();
+		
+		unsigned long id = new_table(table(trie()));
+		
+		if (debug) {
+			cerr << "hash_create_trie()\n";
+			cerr << "hash_create_trie: hash table #" << id << " created\n";
+		}
+		
+		return id;
+	}
+	
+	// Shared part of the prefix queries. Returns the table, or nullptr if the
+	// arguments are invalid or the table does not exist.
+	const table *prefix_query(const char *name, unsigned long id,
+	                          uint64_t const *prefix, size_t size) {
+		if (debug) {
+			cerr << name << "(" << id << ", ";
+			print_sequence(prefix, size);
+			cerr << ", " << size << ")\n";
+		}
+		
+		if (prefix == nullptr && size > 0) {
+			if (debug) {
+				cerr << name << ": invalid pointer (NULL)\n";
+			}
+			return nullptr;
+		}
+		
+		const table *tab = find_table(id);
+		if (tab == nullptr && debug) {
+			cerr << name << ": hash table #" << id << " does not exist\n";
+		}
+		return tab;
+	}
+	
+	size_t hash_prefix_count(unsigned long id, uint64_t const *prefix,
+	                         size_t size) {
+		print_start();
+		
+		const table *tab = prefix_query("hash_prefix_count", id, prefix, size);
+		if (tab == nullptr) {
+			return 0;
+		}
+		
+		size_t count = tab->prefix_count(sequence_view{prefix, size});
+		if (debug) {
+			cerr << "hash_prefix_count: hash table #" << id << " contains "
+			     << count << " element(s) with this prefix\n";
+		}
+		return count;
+	}
+	
+	size_t hash_prefix_enumerate(unsigned long id, uint64_t const *prefix,
+	                             size_t size, hash_visitor_t visitor,
+	                             void *context) {
+		print_start();
+		
+		const table *tab = prefix_query("hash_prefix_enumerate", id, prefix,
+		                                size);
+		if (tab == nullptr) {
+			return 0;
+		}
+		
+		size_t count = 0;
+		tab->prefix_enumerate(sequence_view{prefix, size},
+		                      [&](sequence_view seq) {
+			if (visitor != nullptr) {
+				visitor(seq.data, seq.size, context);
+			}
+			count++;
+		});
+		if (debug) {
+			cerr << "hash_prefix_enumerate: hash table #" << id << ", "
+			     << count << " element(s) visited\n";
+		}
+		return count;
+	}
+	
+	unsigned long hash_create_shared(hash_function_t hash_function,
+	                                 char const *name, size_t capacity,
+	                                 size_t words) {
+		print_start();
+		
+		if (debug) {
+			cerr << "hash_create_shared(" << &hash_function << ", ";
+			if (name != nullptr) {
+				cerr << "\"" << name << "\"";
+			}
+			else {
+				cerr << "NULL";
+			}
+			cerr << ", " << capacity << ", " << words << ")\n";
+		}
+		
+		if (name == nullptr) {
+			if (debug) {
+				cerr << "hash_create_shared: invalid name (NULL)\n";
+			}
+			return no_table;
+		}
+		if (!shared_memory_set::valid_size(capacity, words)) {
+			if (debug) {
+				cerr << "hash_create_shared: invalid capacity or size\n";
+			}
+			return no_table;
+		}
+		
+		auto set = std::make_shared<shared_memory_set>(hasher(hash_function),
+		                                               name, capacity, words);
+		if (!set->attached()) {
+			if (debug) {
+				cerr << "hash_create_shared: cannot attach to \"" << name
+				     << "\"\n";
+			}
+			return no_table;
+		}
+		
+		unsigned long id = new_table(table(std::move(set)));
+		if (debug) {
+			cerr << "hash_create_shared: hash table #" << id
+			     << " attached to \"" << name << "\"\n";
+		}
+		return id;
+	}
+	
+	bool hash_unlink_shared(char const *name) {
+		print_start();
+		
+		if (debug) {
+			cerr << "hash_unlink_shared(";
+			if (name != nullptr) {
+				cerr << "\"" << name << "\"";
+			}
+			else {
+				cerr << "NULL";
+			}
+			cerr << ")\n";
+		}
+		
+		bool unlinked = name != nullptr && shm_unlink(name) == 0;
+		if (debug) {
+			cerr << "hash_unlink_shared: segment "
+			     << (unlinked ? "unlinked\n" : "not unlinked\n");
+		}
+		return unlinked;
+	}
+	
+	unsigned long hash_clone(unsigned long id) {
+		print_start();
+		
+		if (debug) {
+			cerr << "hash_clone(" << id << ")\n";
+			cerr << "hash_clone: hash table #" << id;
+		}
+		table *tab = find_table(id);
+		if (tab == nullptr) {
+			if (debug) {
+				cerr << " does not exist\n";
+			}
+			return no_table;
+		}
+		
+		unsigned long clone_id = new_table(tab->snapshot());
+		if (debug) {
+			cerr << " cloned as hash table #" << clone_id << "\n";
+		}
+		return clone_id;
+	}
+	
+	bool hash_filter(unsigned long id, bool enabled) {
+		print_start();
+		
+		if (debug) {
+			cerr << "hash_filter(" << id << ", " << enabled << ")\n";
+			cerr << "hash_filter: hash table #" << id;
+		}
+		table *tab = find_table(id);
+		if (tab == nullptr) {
+			if (debug) {
+				cerr << " does not exist\n";
+			}
+			return false;
+		}
+		if (!tab->set_filter(enabled)) {
+			if (debug) {
+				cerr << " is in shared memory and cannot be filtered\n";
+			}
+			return false;
+		}
+		if (debug) {
+			cerr << (enabled ? " filtered\n" : " not filtered\n");
+		}
+		return true;
+	}
+	
+	unsigned long hash_union(unsigned long id1, unsigned long id2,
+	                         hash_function_t hash_function) {
+		print_start();
+		prepare_set_operation("hash_union", id1, id2);
+		
+		const table *a = find_table(id1);
+		const table *b = find_table(id2);
+		vector<sequence> from_a = filter(a, nullptr, false);
+		unsigned long id = fill_table(hash_function, from_a,
+		                              filter(b, a, false));
+		
+		print_set_result("hash_union", id);
+		return id;
+	}
+	
+	unsigned long hash_intersection(unsigned long id1, unsigned long id2,
+	                                hash_function_t hash_function) {
+		print_start();
+		prepare_set_operation("hash_intersection", id1, id2);
+		
+		const table *a = find_table(id1);
+		const table *b = find_table(id2);
+		if (a != nullptr && b != nullptr && a->size() > b->size()) {
+			std::swap(a, b);
+		}
+		unsigned long id = fill_table(hash_function,
+		                              filter(a, b, true), {});
+		
+		print_set_result("hash_intersection", id);
+		return id;
+	}
+	
+	unsigned long hash_difference(unsigned long id1, unsigned long id2,
+	                              hash_function_t hash_function) {
+		print_start();
+		prepare_set_operation("hash_difference", id1, id2);
+		
+		unsigned long id = fill_table(hash_function,
+		                              filter(find_table(id1),
+		                                     find_table(id2), false), {});
+		
+		print_set_result("hash_difference", id);
+		return id;
+	}
+	
+	size_t hash_union_size(unsigned long id1, unsigned long id2) {
+		print_start();
+		prepare_set_operation("hash_union_size", id1, id2);
+		
+		const table *a = find_table(id1);
+		const table *b = find_table(id2);
+		size_t size = (a == nullptr ? 0 : a->size()) +
+		              (b == nullptr ? 0 : b->size()) - common_size(a, b);
+		
+		if (debug) {
+			cerr << "hash_union_size: " << size << " element(s)\n";
+		}
+		return size;
+	}
+	
+	size_t hash_intersection_size(unsigned long id1, unsigned long id2) {
+		print_start();
+		prepare_set_operation("hash_intersection_size", id1, id2);
+		
+		size_t size = common_size(find_table(id1), find_table(id2));
+		
+		if (debug) {
+			cerr << "hash_intersection_size: " << size << " element(s)\n";
+		}
+		return size;
+	}
+	
+	size_t hash_difference_size(unsigned long id1, unsigned long id2) {
+		print_start();
+		prepare_set_operation("hash_difference_size", id1, id2);
+		
+		const table *a = find_table(id1);
+		size_t size = a == nullptr ? 0 : a->size() - common_size(a,
+		                                                find_table(id2));
+		
+		if (debug) {
+			cerr << "hash_difference_size: " << size << " element(s)\n";
+		}
+		return size;
+	}
 }
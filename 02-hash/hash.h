@@ -16,8 +16,25 @@ namespace jnp1 {
 		
 		typedef uint64_t (*hash_function_t) (uint64_t const *, size_t);
 		
+		typedef void (*hash_visitor_t) (uint64_t const *, size_t, void *);
+		
 		unsigned long hash_create(hash_function_t);
 		
+		unsigned long hash_create_trie(void);
+		
+		/* Room is fixed at creation: the table holds at most the given
+		 * number of sequences, of at most the given total length. Room of
+		 * removed sequences is reclaimed by a later insert which runs out of
+		 * it, once they take up an eighth of the used room. A table left
+		 * half changed by a process which died is repaired by the next one
+		 * to use it, and a hash_clear cut short may leave some sequences. */
+		unsigned long hash_create_shared(hash_function_t, char const *, size_t,
+		                                 size_t);
+		
+		bool hash_unlink_shared(char const *);
+		
+		unsigned long hash_clone(unsigned long);
+		
 		void hash_delete(unsigned long);
 		
 		size_t hash_size(unsigned long);
@@ -30,6 +47,27 @@ namespace jnp1 {
 		
 		bool hash_test(unsigned long, uint64_t const *, size_t);
 		
+		bool hash_filter(unsigned long, bool);
+		
+		size_t hash_prefix_count(unsigned long, uint64_t const *, size_t);
+		
+		size_t hash_prefix_enumerate(unsigned long, uint64_t const *, size_t,
+		                             hash_visitor_t, void *);
+		
+		unsigned long hash_union(unsigned long, unsigned long, hash_function_t);
+		
+		unsigned long hash_intersection(unsigned long, unsigned long,
+		                                hash_function_t);
+		
+		unsigned long hash_difference(unsigned long, unsigned long,
+		                              hash_function_t);
+		
+		size_t hash_union_size(unsigned long, unsigned long);
+		
+		size_t hash_intersection_size(unsigned long, unsigned long);
+		
+		size_t hash_difference_size(unsigned long, unsigned long);
+		
 #ifdef __cplusplus
 	}
 }
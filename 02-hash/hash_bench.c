@@ -0,0 +1,176 @@
+/*
+ * Benchmark of the hash module called from C, through the same interface a C
+ * client links against.
+ *
+ *     g++ -std=c++20 -O2 -DNDEBUG -c hash.cc -o hash.o
+ *     gcc -std=c11 -O2 -c hash_bench.c -o hash_bench.o
+ *     g++ hash_bench.o hash.o -o hash_bench_c
+ *     ./hash_bench_c
+ *
+ * Operations are timed in batches of BATCH_SIZE and each configuration runs
+ * in a child process of its own, as in hash_bench.cc.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "hash.h"
+
+/* Number of operations timed together. */
+#define BATCH_SIZE 32
+
+static uint64_t rng_state = 2022;
+
+static uint64_t next_random(void) {
+	uint64_t x = (rng_state += 0x9e3779b97f4a7c15ULL);
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+static uint64_t hash_mix(uint64_t const *seq, size_t size) {
+	uint64_t h = size;
+	for (size_t i = 0; i < size; i++) {
+		h ^= seq[i];
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+		h ^= h >> 31;
+	}
+	return h;
+}
+
+static uint64_t hash_low16(uint64_t const *seq, size_t size) {
+	(void) size;
+	return seq[0] & 0xffff;
+}
+
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_doubles(void const *a, void const *b) {
+	double x = *(double const *) a;
+	double y = *(double const *) b;
+	return (x > y) - (x < y);
+}
+
+static long peak_rss_kb(void) {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+enum operation { INSERT, TEST, REMOVE };
+
+static char const *operation_names[] = {"insert", "test", "remove"};
+
+/* latencies gets the mean time of an operation in each batch. */
+static void measure(char const *hash_name, enum operation op, unsigned long id,
+                    uint64_t *const *seqs, size_t count, size_t length,
+                    double *latencies) {
+	size_t batches = 0;
+	double start = now_ns();
+	double batch_start = start;
+	for (size_t first = 0; first < count; first += BATCH_SIZE) {
+		size_t last = first + BATCH_SIZE < count ? first + BATCH_SIZE : count;
+		for (size_t i = first; i < last; i++) {
+			switch (op) {
+			case INSERT:
+				hash_insert(id, seqs[i], length);
+				break;
+			case TEST:
+				hash_test(id, seqs[i], length);
+				break;
+			case REMOVE:
+				hash_remove(id, seqs[i], length);
+				break;
+			}
+		}
+		double batch_end = now_ns();
+		latencies[batches++] = (batch_end - batch_start) / (last - first);
+		batch_start = batch_end;
+	}
+	double seconds = (batch_start - start) / 1e9;
+
+	qsort(latencies, batches, sizeof(double), compare_doubles);
+	printf("%-8s%6zu%10zu%8s%14.0f%10.0f%10.0f%10.0f%12ld\n", hash_name,
+	       length, count, operation_names[op], count / seconds,
+	       latencies[batches / 2], latencies[batches * 99 / 100],
+	       latencies[batches * 999 / 1000], peak_rss_kb());
+}
+
+static void run(char const *hash_name, hash_function_t hash_function,
+                size_t count, size_t length) {
+	uint64_t *data = malloc(2 * count * length * sizeof(uint64_t));
+	uint64_t **present = malloc(count * sizeof(uint64_t *));
+	uint64_t **queries = malloc(count * sizeof(uint64_t *));
+	double *latencies = malloc((count / BATCH_SIZE + 1) * sizeof(double));
+
+	for (size_t i = 0; i < 2 * count * length; i++) {
+		data[i] = next_random();
+	}
+	for (size_t i = 0; i < count; i++) {
+		present[i] = data + i * length;
+	}
+	for (size_t i = 0; i < count; i++) {
+		queries[i] = (i % 2 == 0 ? present[next_random() % count]
+		                         : data + (count + i) * length);
+	}
+
+	unsigned long id = hash_create(hash_function);
+	measure(hash_name, INSERT, id, present, count, length, latencies);
+	measure(hash_name, TEST, id, queries, count, length, latencies);
+	measure(hash_name, REMOVE, id, queries, count, length, latencies);
+	hash_delete(id);
+
+	free(latencies);
+	free(queries);
+	free(present);
+	free(data);
+}
+
+/*
+ * The parent never holds the data of a configuration, so every child starts
+ * from the same small RSS and reports its own peak.
+ */
+static void run_in_child(char const *hash_name, hash_function_t hash_function,
+                         size_t count, size_t length) {
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid == -1) {
+		perror("hash_bench: fork");
+		exit(1);
+	}
+	if (pid == 0) {
+		run(hash_name, hash_function, count, length);
+		fflush(stdout);
+		_exit(0);
+	}
+	waitpid(pid, NULL, 0);
+	/* The child's draws are lost, so move on to fresh data. */
+	rng_state = next_random();
+}
+
+int main(void) {
+	size_t const lengths[] = {1, 4, 32};
+	size_t const sizes[] = {1000, 100000, 1000000};
+
+	printf("%-8s%6s%10s%8s%14s%10s%10s%10s%12s\n", "hash", "len", "size",
+	       "op", "ops/s", "p50ns", "p99ns", "p99.9ns", "peakRSS_kB");
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+			run_in_child("mix", hash_mix, sizes[s], lengths[l]);
+			run_in_child("low16", hash_low16, sizes[s], lengths[l]);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,310 @@
+// Benchmark of the hash module driven through its C interface.
+//
+//     g++ -std=c++20 -O2 -DNDEBUG hash.cc hash_bench.cc -o hash_bench
+//     ./hash_bench [--quick]
+//
+// Without -DNDEBUG every call to the module is logged to stderr and the
+// numbers are meaningless.
+//
+// Operations are timed in batches, as reading the clock around each one
+// would take longer than many of them, so the latency percentiles are of
+// the mean time of an operation in a batch. Each configuration runs in
+// a child process of its own and reports the peak RSS of that process.
+//
+// Before timing anything, it checks that a table in shared memory is
+// usable again after a process is killed while clearing it.
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <csignal>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "hash.h"
+
+namespace {
+	using vi = std::vector<uint64_t>;
+	using std::vector;
+	using std::string;
+	using std::cout;
+	using clock_type = std::chrono::steady_clock;
+
+	#ifndef NDEBUG
+		const bool debug = true;
+	#else
+		const bool debug = false;
+	#endif
+
+	uint64_t mix(uint64_t x) {
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		x ^= x >> 31;
+		return x;
+	}
+
+	uint64_t hash_mix(uint64_t const *seq, size_t size) {
+		uint64_t h = size;
+		for (size_t i = 0; i < size; i++) {
+			h = mix(h ^ seq[i]);
+		}
+		return h;
+	}
+
+	uint64_t hash_sum(uint64_t const *seq, size_t size) {
+		uint64_t h = 0;
+		for (size_t i = 0; i < size; i++) {
+			h += seq[i];
+		}
+		return h;
+	}
+
+	uint64_t hash_low16(uint64_t const *seq, size_t) {
+		return seq[0] & 0xffff;
+	}
+
+	struct hash_kind {
+		string name;
+		jnp1::hash_function_t function;
+	};
+
+	struct config {
+		size_t length;
+		size_t table_size;
+		double hit_ratio;
+		hash_kind hash;
+	};
+
+	// Number of operations timed together.
+	const size_t batch_size = 32;
+
+	struct result {
+		double ops_per_sec;
+		double p50;
+		double p99;
+		double p999;
+	};
+
+	long peak_rss_kb() {
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss;
+	}
+
+	vector<vi> random_sequences(std::mt19937_64 &rng, size_t count,
+	                            size_t length) {
+		vector<vi> ans(count, vi(length));
+		for (vi &seq : ans) {
+			for (uint64_t &x : seq) {
+				x = rng();
+			}
+		}
+		return ans;
+	}
+
+	template <typename Op>
+	result measure(size_t count, Op op) {
+		vector<double> latencies;
+		latencies.reserve(count / batch_size + 1);
+		auto start = clock_type::now();
+		auto batch_start = start;
+		for (size_t first = 0; first < count; first += batch_size) {
+			size_t last = std::min(count, first + batch_size);
+			for (size_t i = first; i < last; i++) {
+				op(i);
+			}
+			auto batch_end = clock_type::now();
+			latencies.push_back(std::chrono::duration<double, std::nano>(
+				batch_end - batch_start).count() / (last - first));
+			batch_start = batch_end;
+		}
+
+		double seconds = std::chrono::duration<double>(batch_start - start)
+		                 .count();
+		std::sort(latencies.begin(), latencies.end());
+		size_t batches = latencies.size();
+		auto percentile = [&](double p) {
+			return latencies[std::min(batches - 1, (size_t) (p * batches))];
+		};
+		return {count / seconds, percentile(0.5), percentile(0.99),
+		        percentile(0.999)};
+	}
+
+	void print_header() {
+		cout << std::left << std::setw(8) << "hash" << std::right
+		     << std::setw(6) << "len" << std::setw(10) << "size"
+		     << std::setw(6) << "hit" << std::setw(8) << "op"
+		     << std::setw(14) << "ops/s" << std::setw(10) << "p50ns"
+		     << std::setw(10) << "p99ns" << std::setw(10) << "p99.9ns"
+		     << std::setw(12) << "peakRSS_kB" << "\n";
+	}
+
+	void print_row(config const &c, char const *op, result const &r) {
+		cout << std::left << std::setw(8) << c.hash.name << std::right
+		     << std::setw(6) << c.length << std::setw(10) << c.table_size
+		     << std::setw(6) << std::fixed << std::setprecision(2)
+		     << c.hit_ratio << std::setw(8) << op
+		     << std::setw(14) << std::setprecision(0) << r.ops_per_sec
+		     << std::setw(10) << r.p50 << std::setw(10) << r.p99
+		     << std::setw(10) << r.p999 << std::setw(12) << peak_rss_kb()
+		     << "\n";
+	}
+
+	void run(config const &c, std::mt19937_64 &rng) {
+		vector<vi> present = random_sequences(rng, c.table_size, c.length);
+		vector<vi> absent = random_sequences(rng, c.table_size, c.length);
+
+		vector<vi const *> queries(c.table_size);
+		std::bernoulli_distribution hit(c.hit_ratio);
+		for (size_t i = 0; i < c.table_size; i++) {
+			queries[i] = hit(rng) ? &present[rng() % c.table_size]
+			                      : &absent[i];
+		}
+
+		unsigned long id = jnp1::hash_create(c.hash.function);
+
+		print_row(c, "insert", measure(c.table_size, [&](size_t i) {
+			jnp1::hash_insert(id, present[i].data(), c.length);
+		}));
+		print_row(c, "test", measure(c.table_size, [&](size_t i) {
+			jnp1::hash_test(id, queries[i]->data(), c.length);
+		}));
+		print_row(c, "remove", measure(c.table_size, [&](size_t i) {
+			jnp1::hash_remove(id, queries[i]->data(), c.length);
+		}));
+
+		jnp1::hash_delete(id);
+	}
+
+	// A process clears a large table over and over and is killed, most
+	// likely with the lock held halfway through. Reading the table must
+	// then not wait forever, and it must hold what its size says.
+	bool check_writer_death() {
+		const char *name = "/hash_bench_writer_death";
+		const uint64_t sequences = 1000;
+		jnp1::hash_unlink_shared(name);
+		unsigned long id = jnp1::hash_create_shared(hash_mix, name, 1 << 20,
+		                                            1 << 16);
+		if (id == ULONG_MAX) {
+			std::cerr << "hash_bench: cannot create " << name << "\n";
+			return false;
+		}
+		
+		// A hang is reported by the default action of SIGALRM.
+		alarm(60);
+		std::mt19937_64 rng(2022);
+		bool ok = true;
+		for (int round = 0; round < 10 && ok; round++) {
+			jnp1::hash_clear(id);
+			for (uint64_t i = 0; i < sequences; i++) {
+				uint64_t seq[2] = {i, i};
+				jnp1::hash_insert(id, seq, 2);
+			}
+			cout.flush();
+			pid_t pid = fork();
+			if (pid == -1) {
+				std::cerr << "hash_bench: fork failed\n";
+				exit(1);
+			}
+			if (pid == 0) {
+				while (true) {
+					jnp1::hash_clear(id);
+				}
+			}
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds(5 + rng() % 50));
+			kill(pid, SIGKILL);
+			waitpid(pid, nullptr, 0);
+			
+			size_t present = 0;
+			for (uint64_t i = 0; i < sequences; i++) {
+				uint64_t seq[2] = {i, i};
+				present += jnp1::hash_test(id, seq, 2);
+			}
+			uint64_t fresh[2] = {sequences + round, 0};
+			ok = present == jnp1::hash_size(id) &&
+			     jnp1::hash_insert(id, fresh, 2) &&
+			     jnp1::hash_test(id, fresh, 2) &&
+			     jnp1::hash_size(id) == present + 1;
+		}
+		alarm(0);
+		
+		jnp1::hash_delete(id);
+		jnp1::hash_unlink_shared(name);
+		if (!ok) {
+			std::cerr << "hash_bench: table inconsistent after a writer "
+			             "was killed\n";
+		}
+		return ok;
+	}
+	
+	// The parent never holds the data of a configuration, so every child
+	// starts from the same small RSS.
+	void run_in_child(config const &c, uint64_t seed) {
+		cout.flush();
+		pid_t pid = fork();
+		if (pid == -1) {
+			std::cerr << "hash_bench: fork failed\n";
+			exit(1);
+		}
+		if (pid == 0) {
+			std::mt19937_64 rng(seed);
+			run(c, rng);
+			cout.flush();
+			_exit(0);
+		}
+		int status;
+		waitpid(pid, &status, 0);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	if (debug) {
+		std::cerr << "hash_bench: built without -DNDEBUG, "
+		             "results include debug logging\n";
+	}
+
+	bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+	
+	if (!check_writer_death()) {
+		return 1;
+	}
+
+	vector<size_t> lengths = {1, 2, 4, 8, 32};
+	vector<size_t> sizes = {1'000, 100'000, 1'000'000};
+	vector<double> hit_ratios = {0.0, 0.05, 0.5, 1.0};
+	vector<hash_kind> hashes = {
+		{"mix", hash_mix},
+		{"sum", hash_sum},
+		{"low16", hash_low16},
+	};
+	if (quick) {
+		lengths = {1, 4, 32};
+		sizes = {1'000, 100'000};
+		hit_ratios = {0.05, 1.0};
+	}
+
+	std::mt19937_64 rng(2022);
+	print_header();
+	for (size_t table_size : sizes) {
+		for (hash_kind const &hash : hashes) {
+			for (size_t length : lengths) {
+				for (double hit_ratio : hit_ratios) {
+					run_in_child({length, table_size, hit_ratio, hash}, rng());
+				}
+			}
+		}
+	}
+
+	return 0;
+}
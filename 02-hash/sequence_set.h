@@ -0,0 +1,393 @@
+#ifndef SEQUENCE_SET_H
+#define SEQUENCE_SET_H
+
+#include <unordered_set>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace jnp1 {
+	// Non-owning view of a sequence, used for lookups so that they do not copy
+	// the sequence.
+	struct sequence_view {
+		uint64_t const *data;
+		size_t size;
+		
+		uint64_t operator[](size_t i) const {
+			return data[i];
+		}
+	};
+	
+	namespace details {
+		// Sequence stored in a hash table. Sequences of at most inline_size
+		// elements are kept inside the object, padded with zeros, so they need no
+		// heap buffer and compare in a fixed number of instructions. Longer ones
+		// are kept on the heap.
+		class sequence {
+		private:
+			static const size_t inline_size = 4;
+			
+			size_t length;
+			union {
+				uint64_t inline_values[inline_size];
+				uint64_t *heap_values;
+			};
+			
+			bool is_inline() const {
+				return length <= inline_size;
+			}
+			
+			void assign(uint64_t const *seq, size_t size) {
+				length = size;
+				if (is_inline()) {
+					std::fill(inline_values, inline_values + inline_size, 0);
+					std::copy(seq, seq + size, inline_values);
+				}
+				else {
+					heap_values = new uint64_t[size];
+					std::copy(seq, seq + size, heap_values);
+				}
+			}
+			
+		public:
+			sequence(uint64_t const *seq, size_t size) {
+				assign(seq, size);
+			}
+			
+			sequence(const sequence &other) {
+				assign(other.data(), other.size());
+			}
+			
+			sequence(sequence &&other) noexcept : length(other.length) {
+				if (is_inline()) {
+					std::copy(other.inline_values,
+					          other.inline_values + inline_size, inline_values);
+				}
+				else {
+					heap_values = other.heap_values;
+					other.length = 0;
+					std::fill(other.inline_values,
+					          other.inline_values + inline_size, 0);
+				}
+			}
+			
+			sequence &operator=(sequence other) noexcept {
+				std::swap(length, other.length);
+				std::swap(inline_values, other.inline_values);
+				return *this;
+			}
+			
+			~sequence() {
+				if (!is_inline()) {
+					delete[] heap_values;
+				}
+			}
+			
+			uint64_t const *data() const {
+				return is_inline() ? inline_values : heap_values;
+			}
+			
+			size_t size() const {
+				return length;
+			}
+			
+			sequence_view view() const {
+				return {data(), length};
+			}
+			
+			bool operator==(const sequence &other) const {
+				if (length != other.length) {
+					return false;
+				}
+				if (is_inline()) {
+					return inline_values[0] == other.inline_values[0] &&
+					       inline_values[1] == other.inline_values[1] &&
+					       inline_values[2] == other.inline_values[2] &&
+					       inline_values[3] == other.inline_values[3];
+				}
+				return std::equal(heap_values, heap_values + length,
+				                  other.heap_values);
+			}
+		};
+		
+		template <typename Hasher>
+		class view_hasher {
+		private:
+			Hasher hash;
+		public:
+			using is_transparent = void;
+			
+			explicit view_hasher(const Hasher &_hash) : hash(_hash) {}
+			
+			uint64_t operator()(sequence_view seq) const {
+				assert(seq.size > 0);
+				return hash(seq.data, seq.size);
+			}
+			
+			uint64_t operator()(const sequence &seq) const {
+				return (*this)(seq.view());
+			}
+			
+			const Hasher &function() const {
+				return hash;
+			}
+		};
+		
+		struct sequence_equal {
+			using is_transparent = void;
+			
+			bool operator()(const sequence &a, const sequence &b) const {
+				return a == b;
+			}
+			
+			bool operator()(sequence_view a, const sequence &b) const {
+				return a.size == b.size() &&
+				       std::equal(a.data, a.data + a.size, b.data());
+			}
+			
+			bool operator()(const sequence &a, sequence_view b) const {
+				return (*this)(b, a);
+			}
+		};
+		
+		template <typename Hasher>
+		using hash_set = std::unordered_set<sequence, view_hasher<Hasher>,
+		                                    sequence_equal>;
+		
+		// Hash of a sequence independent of the user's hash function, used where
+		// the module needs well mixed bits of its own.
+		inline uint64_t mix_hash(sequence_view seq) {
+			uint64_t h = seq.size * 0x9e3779b97f4a7c15ULL;
+			for (size_t i = 0; i < seq.size; i++) {
+				h = (h ^ seq[i]) * 0xbf58476d1ce4e5b9ULL;
+				h ^= h >> 31;
+			}
+			return h * 0x94d049bb133111ebULL;
+		}
+		
+		// Hash set which grows without rehashing all of its elements at once.
+		// When current fills up it becomes old, and a new current with growth
+		// times as many buckets takes its place. Every later write moves an
+		// element from old to current, so the cost of growing is spread over
+		// them, and the migration ends after a third of the writes which fill
+		// current up again. Moving one element per write rather than several
+		// keeps the tail latency of writes from rising with the size of the
+		// set, and growing four times rather than twice leaves most writes with
+		// nothing to move and no second set to look in.
+		template <typename Hasher>
+		class incremental_set {
+		private:
+			static const size_t migration_step = 1;
+			
+			static const size_t growth = 4;
+			
+			hash_set<Hasher> current;
+			hash_set<Hasher> old;
+			
+			void migrate(size_t count) {
+				if (old.empty()) {
+					return;
+				}
+				while (count-- > 0 && !old.empty()) {
+					current.insert(old.extract(old.begin()));
+				}
+				if (old.empty()) {
+					old = hash_set<Hasher>(0, current.hash_function());
+				}
+			}
+			
+			void grow() {
+				migrate(old.size());
+				size_t buckets = growth * current.bucket_count();
+				std::swap(old, current);
+				current = hash_set<Hasher>(buckets, old.hash_function());
+			}
+			
+		public:
+			explicit incremental_set(const view_hasher<Hasher> &hash)
+				: current(16, hash), old(0, hash) {}
+			
+			size_t size() const {
+				return current.size() + old.size();
+			}
+			
+			void reserve(size_t size) {
+				migrate(old.size());
+				current.reserve(size);
+			}
+			
+			bool contains(sequence_view seq) const {
+				return current.find(seq) != current.end() ||
+				       (!old.empty() && old.find(seq) != old.end());
+			}
+			
+			bool insert(sequence_view seq) {
+				migrate(migration_step);
+				if (!old.empty() && old.find(seq) != old.end()) {
+					return false;
+				}
+				if (current.size() + 1 >
+				    current.max_load_factor() * current.bucket_count()) {
+					grow();
+					if (old.find(seq) != old.end()) {
+						return false;
+					}
+				}
+				return current.emplace(seq.data, seq.size).second;
+			}
+			
+			bool remove(sequence_view seq) {
+				migrate(migration_step);
+				auto it = current.find(seq);
+				if (it != current.end()) {
+					current.erase(it);
+					return true;
+				}
+				it = old.find(seq);
+				if (it != old.end()) {
+					old.erase(it);
+					return true;
+				}
+				return false;
+			}
+			
+			template <typename Visitor>
+			void for_each(Visitor &visit) const {
+				for (const hash_set<Hasher> *set : {&current, &old}) {
+					for (const sequence &seq : *set) {
+						visit(seq.view());
+					}
+				}
+			}
+		};
+	}
+	
+	// Set of non-empty sequences of uint64_t, hashed with Hasher, a type
+	// callable as uint64_t(uint64_t const *, size_t). The set is split into
+	// shards by details::mix_hash. Copies of a sequence_set share their
+	// shards, a shard is copied on the first write to it, so copying a set is
+	// cheap. The sets behind the C interface of hash.h are sequence_sets.
+	template <typename Hasher>
+	class sequence_set {
+	private:
+		static const size_t shard_count = 32;
+		
+		using shard_set = details::incremental_set<Hasher>;
+		
+		details::view_hasher<Hasher> hash;
+		std::array<std::shared_ptr<shard_set>, shard_count> shards;
+		size_t count = 0;
+		
+		static size_t shard_of(sequence_view seq) {
+			return details::mix_hash(seq) % shard_count;
+		}
+		
+		shard_set &writable_shard(size_t shard) {
+			if (shards[shard] == nullptr) {
+				shards[shard] = std::make_shared<shard_set>(hash);
+			}
+			else if (shards[shard].use_count() > 1) {
+				shards[shard] = std::make_shared<shard_set>(*shards[shard]);
+			}
+			return *shards[shard];
+		}
+		
+	public:
+		explicit sequence_set(const Hasher &_hash = Hasher()) : hash(_hash) {}
+		
+		const Hasher &hash_function() const {
+			return hash.function();
+		}
+		
+		size_t size() const {
+			return count;
+		}
+		
+		bool empty() const {
+			return count == 0;
+		}
+		
+		void clear() {
+			shards = {};
+			count = 0;
+		}
+		
+		void reserve(size_t size) {
+			for (size_t shard = 0; shard < shard_count; shard++) {
+				writable_shard(shard).reserve(size / shard_count);
+			}
+		}
+		
+		bool contains(sequence_view seq) const {
+			const shard_set *set = shards[shard_of(seq)].get();
+			return set != nullptr && set->contains(seq);
+		}
+		
+		// A shard shared with a copy is checked first, so that it is not
+		// copied by a write which would not change it.
+		bool insert(sequence_view seq) {
+			size_t shard = shard_of(seq);
+			if (shards[shard].use_count() > 1 && shards[shard]->contains(seq)) {
+				return false;
+			}
+			if (!writable_shard(shard).insert(seq)) {
+				return false;
+			}
+			count++;
+			return true;
+		}
+		
+		bool remove(sequence_view seq) {
+			size_t shard = shard_of(seq);
+			if (shards[shard] == nullptr ||
+			    (shards[shard].use_count() > 1 &&
+			     !shards[shard]->contains(seq))) {
+				return false;
+			}
+			if (!writable_shard(shard).remove(seq)) {
+				return false;
+			}
+			count--;
+			return true;
+		}
+		
+		bool contains(uint64_t const *seq, size_t size) const {
+			return contains(sequence_view{seq, size});
+		}
+		
+		bool insert(uint64_t const *seq, size_t size) {
+			return insert(sequence_view{seq, size});
+		}
+		
+		bool remove(uint64_t const *seq, size_t size) {
+			return remove(sequence_view{seq, size});
+		}
+		
+		template <typename Visitor>
+		void for_each(Visitor visit) const {
+			for_each(0, partition_range(), visit);
+		}
+		
+		// The sequences are split into partition_range() slices, for_each
+		// visits the slices [first, last), so that slices can be visited in
+		// parallel.
+		size_t partition_range() const {
+			return shard_count;
+		}
+		
+		template <typename Visitor>
+		void for_each(size_t first, size_t last, Visitor visit) const {
+			for (size_t shard = first; shard < last; shard++) {
+				if (shards[shard] != nullptr) {
+					shards[shard]->for_each(visit);
+				}
+			}
+		}
+	};
+}
+
+#endif /* SEQUENCE_SET_H */
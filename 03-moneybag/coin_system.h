@@ -0,0 +1,354 @@
+#ifndef COIN_SYSTEM_H
+#define COIN_SYSTEM_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "moneybag.h"
+
+// A coin system is a type with two static members:
+//   ratios - how many of the next smaller coin each coin is worth, for all
+//            coins but the smallest, largest coin first,
+//   names  - the singular and plural name of each coin, largest first.
+// CoinBag<System> and CoinValue<System> then work like Moneybag and Value.
+
+struct FrankishCoins {
+    static constexpr std::array<uint64_t, 2> ratios = {20, 12};
+    static constexpr std::array<std::array<std::string_view, 2>, 3> names = {{
+            {"livr", "livres"},
+            {"solidus", "soliduses"},
+            {"denier", "deniers"},
+    }};
+};
+
+namespace details {
+    // Worth of each coin in the smallest one, largest coin first.
+    template <typename System>
+    constexpr auto coinWorths() {
+        constexpr std::size_t kinds = System::ratios.size() + 1;
+        std::array<__uint128_t, kinds> worths{};
+        worths[kinds - 1] = 1;
+        for (std::size_t kind = kinds - 1; kind > 0; kind--) {
+            worths[kind - 1] = worths[kind] * System::ratios[kind - 1];
+        }
+        return worths;
+    }
+
+    // Length of the longest text CoinBag<System>::toString() can return:
+    // the counts of up to 20 digits, the longer name of each coin, the
+    // separators and the parentheses.
+    template <typename System>
+    constexpr std::size_t maxBagChars() {
+        std::size_t chars = 2 + 2 * (System::names.size() - 1);
+        for (const auto &name : System::names) {
+            chars += 20 + 1 + std::max(name[0].size(), name[1].size());
+        }
+        return chars;
+    }
+
+    // The value of a full bag has to fit in 128 bits.
+    template <typename System>
+    constexpr bool fitsInValue() {
+        __uint128_t sum = 0;
+        for (__uint128_t worth : coinWorths<System>()) {
+            if (worth > UINT64_MAX || sum > UINT64_MAX - worth) {
+                return false;
+            }
+            sum += worth;
+        }
+        return true;
+    }
+}
+
+template <typename System>
+class CoinBag {
+public:
+    using coin_number_t = uint64_t;
+
+    static constexpr std::size_t kinds = System::ratios.size() + 1;
+
+    static_assert(System::names.size() == kinds,
+                  "A coin system needs a name for every coin.");
+    static_assert(details::fitsInValue<System>(),
+                  "The value of a bag must fit in 128 bits.");
+
+    static constexpr std::array<__uint128_t, kinds> worths =
+            details::coinWorths<System>();
+
+    template <typename... Counts>
+    requires (sizeof...(Counts) == kinds)
+    constexpr explicit CoinBag(Counts... numbers)
+            : counts{(coin_number_t) numbers...} {}
+
+    constexpr coin_number_t number(std::size_t kind) const {
+        return counts[kind];
+    }
+
+    constexpr CoinBag &operator+=(const CoinBag &snd);
+
+    constexpr CoinBag &operator-=(const CoinBag &snd);
+
+    constexpr CoinBag &operator*=(coin_number_t multiplier);
+
+    constexpr CoinBag operator+(const CoinBag &snd) const {
+        return CoinBag(*this) += snd;
+    }
+
+    constexpr CoinBag operator-(const CoinBag &snd) const {
+        return CoinBag(*this) -= snd;
+    }
+
+    constexpr CoinBag operator*(coin_number_t multiplier) const {
+        return CoinBag(*this) *= multiplier;
+    }
+
+    constexpr std::optional<CoinBag> checkedAdd(const CoinBag &snd) const;
+
+    constexpr std::optional<CoinBag>
+    checkedSubtract(const CoinBag &snd) const;
+
+    constexpr std::optional<CoinBag>
+    checkedMultiply(coin_number_t multiplier) const;
+
+    constexpr bool operator==(const CoinBag &snd) const = default;
+
+    constexpr std::partial_ordering operator<=>(const CoinBag &snd) const;
+
+    constexpr explicit operator bool() const;
+
+    std::string toString() const;
+
+    // The longest text toString() can return.
+    static constexpr std::size_t max_chars = details::maxBagChars<System>();
+
+    std::to_chars_result toChars(char *first, char *last) const;
+
+private:
+    std::array<coin_number_t, kinds> counts;
+
+    // Writes the text of toString() at out, which has room for max_chars,
+    // and returns its end.
+    char *write(char *out) const;
+
+    constexpr CoinBag() : counts{} {}
+};
+
+template <typename System>
+constexpr CoinBag<System>
+operator*(uint64_t multiplier, const CoinBag<System> &bag) {
+    return bag * multiplier;
+}
+
+// The loops below run over a compile-time number of coins and are unrolled,
+// so each system gets the same code Moneybag has written out by hand.
+
+template <typename System>
+constexpr std::optional<CoinBag<System>>
+CoinBag<System>::checkedAdd(const CoinBag &snd) const {
+    CoinBag result;
+    bool overflow = false;
+    for (std::size_t kind = 0; kind < kinds; kind++) {
+        overflow |= __builtin_add_overflow(counts[kind], snd.counts[kind],
+                                           &result.counts[kind]);
+    }
+    return overflow ? std::nullopt : std::optional(result);
+}
+
+template <typename System>
+constexpr std::optional<CoinBag<System>>
+CoinBag<System>::checkedSubtract(const CoinBag &snd) const {
+    CoinBag result;
+    bool overflow = false;
+    for (std::size_t kind = 0; kind < kinds; kind++) {
+        overflow |= __builtin_sub_overflow(counts[kind], snd.counts[kind],
+                                           &result.counts[kind]);
+    }
+    return overflow ? std::nullopt : std::optional(result);
+}
+
+template <typename System>
+constexpr std::optional<CoinBag<System>>
+CoinBag<System>::checkedMultiply(const coin_number_t multiplier) const {
+    CoinBag result;
+    bool overflow = false;
+    for (std::size_t kind = 0; kind < kinds; kind++) {
+        overflow |= __builtin_mul_overflow(counts[kind], multiplier,
+                                           &result.counts[kind]);
+    }
+    return overflow ? std::nullopt : std::optional(result);
+}
+
+template <typename System>
+constexpr CoinBag<System> &CoinBag<System>::operator+=(const CoinBag &snd) {
+    std::optional<CoinBag> result = checkedAdd(snd);
+    if (!result) {
+        throw std::out_of_range(
+                "Addition would result in integer overflow.");
+    }
+    return *this = *result;
+}
+
+template <typename System>
+constexpr CoinBag<System> &CoinBag<System>::operator-=(const CoinBag &snd) {
+    std::optional<CoinBag> result = checkedSubtract(snd);
+    if (!result) {
+        throw std::out_of_range(
+                "Subtraction would result in negative number of coins.");
+    }
+    return *this = *result;
+}
+
+template <typename System>
+constexpr CoinBag<System> &
+CoinBag<System>::operator*=(const coin_number_t multiplier) {
+    std::optional<CoinBag> result = checkedMultiply(multiplier);
+    if (!result) {
+        throw std::out_of_range(
+                "Multiplication would result in integer overflow.");
+    }
+    return *this = *result;
+}
+
+template <typename System>
+constexpr std::partial_ordering
+CoinBag<System>::operator<=>(const CoinBag &snd) const {
+    bool less = true, greater = true;
+    for (std::size_t kind = 0; kind < kinds; kind++) {
+        less &= counts[kind] <= snd.counts[kind];
+        greater &= counts[kind] >= snd.counts[kind];
+    }
+    if (less && greater) {
+        return std::partial_ordering::equivalent;
+    } else if (less) {
+        return std::partial_ordering::less;
+    } else if (greater) {
+        return std::partial_ordering::greater;
+    } else {
+        return std::partial_ordering::unordered;
+    }
+}
+
+template <typename System>
+constexpr CoinBag<System>::operator bool() const {
+    for (coin_number_t count : counts) {
+        if (count != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename System>
+char *CoinBag<System>::write(char *out) const {
+    auto append = [&out](std::string_view text) {
+        std::memcpy(out, text.data(), text.size());
+        out += text.size();
+    };
+    *out++ = '(';
+    for (std::size_t kind = 0; kind < kinds; kind++) {
+        if (kind > 0) {
+            append(", ");
+        }
+        out = std::to_chars(out, out + 20, counts[kind]).ptr;
+        *out++ = ' ';
+        append(System::names[kind][counts[kind] == 1 ? 0 : 1]);
+    }
+    *out++ = ')';
+    return out;
+}
+
+template <typename System>
+std::to_chars_result
+CoinBag<System>::toChars(char *first, char *last) const {
+    if (last - first >= (std::ptrdiff_t) max_chars) {
+        return {write(first), std::errc()};
+    }
+    char buffer[max_chars];
+    std::size_t length = write(buffer) - buffer;
+    if ((std::size_t) (last - first) < length) {
+        return {last, std::errc::value_too_large};
+    }
+    std::memcpy(first, buffer, length);
+    return {first + length, std::errc()};
+}
+
+template <typename System>
+std::string CoinBag<System>::toString() const {
+    char buffer[max_chars];
+    return std::string(buffer, write(buffer));
+}
+
+template <typename System>
+std::ostream &
+operator<<(std::ostream &stream, const CoinBag<System> &bag) {
+    char buffer[CoinBag<System>::max_chars];
+    auto [end, error] = bag.toChars(buffer, buffer + sizeof buffer);
+    return stream << std::string_view(buffer, end - buffer);
+}
+
+// Value of a bag in the smallest coin of its system.
+template <typename System>
+class CoinValue {
+public:
+    using coin_number_t = typename CoinBag<System>::coin_number_t;
+
+    constexpr CoinValue() : amount(0) {}
+
+    constexpr explicit CoinValue(const CoinBag<System> &bag);
+
+    constexpr explicit CoinValue(const coin_number_t smallest)
+            : amount(smallest) {}
+
+    constexpr __uint128_t smallest_number() const { return amount; }
+
+    constexpr bool operator==(const CoinValue &value) const = default;
+
+    constexpr std::strong_ordering
+    operator<=>(const CoinValue &value) const = default;
+
+    constexpr bool operator==(const coin_number_t smallest) const {
+        return amount == smallest;
+    }
+
+    constexpr std::strong_ordering
+    operator<=>(const coin_number_t smallest) const {
+        return amount <=> (__uint128_t) smallest;
+    }
+
+    explicit operator std::string() const {
+        return std::string(Value::fromDeniers(amount));
+    }
+
+private:
+    __uint128_t amount;
+};
+
+template <typename System>
+constexpr CoinValue<System>::CoinValue(const CoinBag<System> &bag)
+        : amount(0) {
+    for (std::size_t kind = 0; kind < CoinBag<System>::kinds; kind++) {
+        amount += CoinBag<System>::worths[kind] * bag.number(kind);
+    }
+}
+
+using FrankishBag = CoinBag<FrankishCoins>;
+using FrankishValue = CoinValue<FrankishCoins>;
+
+// The generic Frankish system is the same currency as Moneybag.
+static_assert(FrankishBag::worths[0] == 240 && FrankishBag::worths[1] == 12);
+static_assert(FrankishBag::max_chars == Moneybag::max_chars);
+static_assert(FrankishValue(FrankishBag(3, 7, 11)).smallest_number() ==
+              Value(Moneybag(3, 7, 11)).denier_number());
+static_assert(FrankishValue(FrankishBag(UINT64_MAX, UINT64_MAX, UINT64_MAX))
+                      .smallest_number() ==
+              Value(Moneybag(UINT64_MAX, UINT64_MAX, UINT64_MAX))
+                      .denier_number());
+
+#endif //COIN_SYSTEM_H
@@ -0,0 +1,189 @@
+#ifndef CONCURRENT_MONEYBAG_H
+#define CONCURRENT_MONEYBAG_H
+
+#include <array>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include "moneybag.h"
+#include "ledger.h"
+
+// A running total of moneybags that many threads add to at once, without
+// locks. Each thread adds into one of a fixed number of shards, each on its
+// own cache line. A shard keeps every coin count as a 64-bit sum that wraps
+// around plus a count of the wrap-arounds, so nothing overflows while adding
+// and the overflow rules of Moneybag are applied only when reading. Only a
+// reader which keeps finding a shard busy makes adds to it wait.
+class ConcurrentMoneybag {
+public:
+    ConcurrentMoneybag() = default;
+
+    ConcurrentMoneybag(const ConcurrentMoneybag &) = delete;
+
+    ConcurrentMoneybag &operator=(const ConcurrentMoneybag &) = delete;
+
+    void add(const Moneybag &moneybag);
+
+    // Every add which returned before the call is included and every other
+    // one either fully or not at all. value is exact; moneybag is empty
+    // where operator+ would have thrown.
+    LedgerTotal snapshot() const;
+
+    // Throws std::out_of_range where summing with operator+ would have.
+    Moneybag balance() const;
+
+    Value value() const { return snapshot().value; }
+
+private:
+    static constexpr std::size_t shard_count = 32;
+
+    // Rounds of reads of the busy shards after which a reader stops new
+    // adds to those still busy.
+    static constexpr int max_optimistic_rounds = 4;
+
+    // An add increments started, then updates the sums, then increments
+    // finished. A reader which sees finished == started around its reads of
+    // the sums has seen no add half done. A reader which keeps failing
+    // increments excluding, and while it is not zero adds which have not
+    // updated the sums yet increment finished at once and wait.
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> low[3] = {0, 0, 0};
+        std::atomic<uint64_t> carries[3] = {0, 0, 0};
+        std::atomic<uint64_t> started = 0;
+        std::atomic<uint64_t> finished = 0;
+        std::atomic<uint32_t> excluding = 0;
+    };
+
+    // Mutable because readers may hold off adds to a shard.
+    mutable std::array<Shard, shard_count> shards;
+
+    static std::size_t threadShard();
+
+    static void addCoins(Shard &shard, std::size_t coin, uint64_t count);
+
+    static details::CoinSums loadSums(const Shard &shard);
+
+    static bool tryRead(const Shard &shard, details::CoinSums &sums);
+
+    static void waitForAdds(const Shard &shard);
+};
+
+inline std::size_t ConcurrentMoneybag::threadShard() {
+    static std::atomic<std::size_t> next_shard = 0;
+    thread_local std::size_t shard =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % shard_count;
+    return shard;
+}
+
+inline void ConcurrentMoneybag::addCoins(Shard &shard, std::size_t coin,
+                                         uint64_t count) {
+    uint64_t old = shard.low[coin].fetch_add(count,
+                                             std::memory_order_relaxed);
+    if (old + count < old) {
+        shard.carries[coin].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// started is incremented before excluding is read, and snapshot()
+// increments excluding before it reads started, both in the single total
+// order of seq_cst operations. So either the add sees excluding set, or
+// the reader waits for the add to finish.
+inline void ConcurrentMoneybag::add(const Moneybag &moneybag) {
+    Shard &shard = shards[threadShard()];
+    shard.started.fetch_add(1, std::memory_order_seq_cst);
+    while (shard.excluding.load(std::memory_order_seq_cst) != 0) {
+        shard.finished.fetch_add(1, std::memory_order_release);
+        while (shard.excluding.load(std::memory_order_relaxed) != 0) {
+            std::this_thread::yield();
+        }
+        shard.started.fetch_add(1, std::memory_order_seq_cst);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    addCoins(shard, 0, moneybag.livre_number());
+    addCoins(shard, 1, moneybag.solidus_number());
+    addCoins(shard, 2, moneybag.denier_number());
+    shard.finished.fetch_add(1, std::memory_order_release);
+}
+
+inline details::CoinSums ConcurrentMoneybag::loadSums(const Shard &shard) {
+    __uint128_t sums[3];
+    for (std::size_t coin = 0; coin < 3; coin++) {
+        uint64_t low = shard.low[coin].load(std::memory_order_relaxed);
+        uint64_t carries =
+                shard.carries[coin].load(std::memory_order_relaxed);
+        sums[coin] = ((__uint128_t) carries << 64) + low;
+    }
+    return {sums[0], sums[1], sums[2]};
+}
+
+inline bool ConcurrentMoneybag::tryRead(const Shard &shard,
+                                        details::CoinSums &sums) {
+    uint64_t finished = shard.finished.load(std::memory_order_acquire);
+    sums = loadSums(shard);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return shard.started.load(std::memory_order_relaxed) == finished;
+}
+
+// finished is read before started, so an add counted in started but not
+// yet finished keeps them apart.
+inline void ConcurrentMoneybag::waitForAdds(const Shard &shard) {
+    while (true) {
+        uint64_t finished = shard.finished.load(std::memory_order_acquire);
+        if (shard.started.load(std::memory_order_seq_cst) == finished) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+// An add which is not running, like one of a thread which has been
+// preempted, keeps its shard busy, so between rounds the reader yields.
+// The shards still busy after that are all held off at once, so that
+// their adds in progress finish in the same wait.
+inline LedgerTotal ConcurrentMoneybag::snapshot() const {
+    details::CoinSums total;
+    std::array<Shard *, shard_count> busy;
+    std::size_t busy_count = 0;
+    for (Shard &shard : shards) {
+        busy[busy_count++] = &shard;
+    }
+
+    for (int round = 0; round < max_optimistic_rounds && busy_count > 0;
+         round++) {
+        if (round > 0) {
+            std::this_thread::yield();
+        }
+        std::size_t still_busy = 0;
+        for (std::size_t i = 0; i < busy_count; i++) {
+            details::CoinSums sums;
+            if (tryRead(*busy[i], sums)) {
+                total += sums;
+            } else {
+                busy[still_busy++] = busy[i];
+            }
+        }
+        busy_count = still_busy;
+    }
+
+    for (std::size_t i = 0; i < busy_count; i++) {
+        busy[i]->excluding.fetch_add(1, std::memory_order_seq_cst);
+    }
+    for (std::size_t i = 0; i < busy_count; i++) {
+        waitForAdds(*busy[i]);
+        total += loadSums(*busy[i]);
+    }
+    for (std::size_t i = 0; i < busy_count; i++) {
+        busy[i]->excluding.fetch_sub(1, std::memory_order_release);
+    }
+    return details::toLedgerTotal(total);
+}
+
+inline Moneybag ConcurrentMoneybag::balance() const {
+    std::optional<Moneybag> moneybag = snapshot().moneybag;
+    if (!moneybag) {
+        throw std::out_of_range("Addition would result in integer overflow.");
+    }
+    return *moneybag;
+}
+
+#endif //CONCURRENT_MONEYBAG_H
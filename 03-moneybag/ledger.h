@@ -0,0 +1,119 @@
+#ifndef LEDGER_H
+#define LEDGER_H
+
+#include <optional>
+#include <stdexcept>
+#include <vector>
+#include "moneybag.h"
+#include "moneybag_vector.h"
+#include "parallel_parts.h"
+
+// Total of a ledger. value is always exact. moneybag is empty when some coin
+// count does not fit in coin_number_t, which is where summing with operator+
+// would have thrown.
+struct LedgerTotal {
+    Value value;
+    std::optional<Moneybag> moneybag;
+};
+
+namespace details {
+    // Longest ledger whose total is computed exactly. Each coin sum is below
+    // size * 2^64, so the value 240 * livres + 12 * soliduses + deniers is
+    // below 253 * size * 2^64, which fits in 128 bits for size < 2^64 / 253.
+    constexpr std::size_t max_ledger_size = UINT64_MAX / 253;
+
+    // Sums of each coin over a part of a ledger.
+    struct CoinSums {
+        __uint128_t livre = 0;
+        __uint128_t solidus = 0;
+        __uint128_t denier = 0;
+
+        CoinSums &operator+=(const CoinSums &snd) {
+            livre += snd.livre;
+            solidus += snd.solidus;
+            denier += snd.denier;
+            return *this;
+        }
+    };
+
+    // The low halves are summed with wrap-around and the carries counted
+    // separately, which keeps the loop in 64-bit registers.
+    inline __uint128_t
+    wideSum(const Moneybag::coin_number_t *first, std::size_t count) {
+        Moneybag::coin_number_t low = 0, carries = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            low += first[i];
+            carries += low < first[i];
+        }
+        return ((__uint128_t) carries << 64) + low;
+    }
+
+    inline CoinSums sumPart(const Moneybag *first, std::size_t count) {
+        Moneybag::coin_number_t low[3] = {0, 0, 0};
+        Moneybag::coin_number_t carries[3] = {0, 0, 0};
+        for (std::size_t i = 0; i < count; i++) {
+            low[0] += first[i].livre_number();
+            carries[0] += low[0] < first[i].livre_number();
+            low[1] += first[i].solidus_number();
+            carries[1] += low[1] < first[i].solidus_number();
+            low[2] += first[i].denier_number();
+            carries[2] += low[2] < first[i].denier_number();
+        }
+        return {((__uint128_t) carries[0] << 64) + low[0],
+                ((__uint128_t) carries[1] << 64) + low[1],
+                ((__uint128_t) carries[2] << 64) + low[2]};
+    }
+
+    // Adds up sum_part(begin, count) over the parts of [0, size) given by
+    // mapParts.
+    template <typename SumPart>
+    CoinSums sumParallel(std::size_t size, SumPart sum_part) {
+        if (size > max_ledger_size) {
+            throw std::out_of_range("Ledger too long to sum exactly.");
+        }
+        CoinSums total;
+        for (const CoinSums &sum : mapParts(
+                size, [&](std::size_t begin, std::size_t end) {
+                    return sum_part(begin, end - begin);
+                })) {
+            total += sum;
+        }
+        return total;
+    }
+
+    inline LedgerTotal toLedgerTotal(const CoinSums &sums) {
+        LedgerTotal total{Value::fromDeniers(sums.livre * 240 +
+                                             sums.solidus * 12 + sums.denier),
+                          std::nullopt};
+        if (sums.livre <= UINT64_MAX && sums.solidus <= UINT64_MAX &&
+            sums.denier <= UINT64_MAX) {
+            total.moneybag = Moneybag((Moneybag::coin_number_t) sums.livre,
+                                      (Moneybag::coin_number_t) sums.solidus,
+                                      (Moneybag::coin_number_t) sums.denier);
+        }
+        return total;
+    }
+}
+
+inline LedgerTotal sumLedger(const Moneybag *first, const Moneybag *last) {
+    return details::toLedgerTotal(details::sumParallel(
+            last - first, [first](std::size_t begin, std::size_t count) {
+                return details::sumPart(first + begin, count);
+            }));
+}
+
+inline LedgerTotal sumLedger(const std::vector<Moneybag> &ledger) {
+    return sumLedger(ledger.data(), ledger.data() + ledger.size());
+}
+
+inline LedgerTotal sumLedger(const MoneybagVector &ledger) {
+    return details::toLedgerTotal(details::sumParallel(
+            ledger.size(), [&ledger](std::size_t begin, std::size_t count) {
+                return details::CoinSums{
+                        details::wideSum(ledger.livres() + begin, count),
+                        details::wideSum(ledger.soliduses() + begin, count),
+                        details::wideSum(ledger.deniers() + begin, count)};
+            }));
+}
+
+#endif //LEDGER_H
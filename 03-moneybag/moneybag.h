@@ -2,8 +2,14 @@
 #define MONEYBAG_H
 
 #include <iostream>
+#include <algorithm>
+#include <bit>
+#include <charconv>
 #include <compare>
 #include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
 
 using std::partial_ordering;
 using std::strong_ordering;
@@ -41,6 +47,21 @@ public:
 
     constexpr Moneybag operator*(coin_number_t multiplier) const;
 
+    constexpr std::optional<Moneybag>
+    checkedAdd(const Moneybag &snd) const;
+
+    constexpr std::optional<Moneybag>
+    checkedSubtract(const Moneybag &snd) const;
+
+    constexpr std::optional<Moneybag>
+    checkedMultiply(coin_number_t multiplier) const;
+
+    constexpr Moneybag saturatingAdd(const Moneybag &snd) const;
+
+    constexpr Moneybag saturatingSubtract(const Moneybag &snd) const;
+
+    constexpr Moneybag saturatingMultiply(coin_number_t multiplier) const;
+
     constexpr bool operator==(const Moneybag &snd) const;
 
     constexpr bool operator!=(const Moneybag &snd) const;
@@ -52,6 +73,16 @@ public:
 
     string toString() const;
 
+    // The longest text toString() can return.
+    static constexpr std::size_t max_chars = 91;
+
+    std::to_chars_result toChars(char *first, char *last) const;
+
+    // Parses the form toString() produces, so numbers with leading zeros
+    // are rejected.
+    static std::from_chars_result
+    fromChars(const char *first, const char *last, Moneybag &moneybag);
+
 private:
     coin_number_t livre;
     coin_number_t solidus;
@@ -65,6 +96,17 @@ private:
 
     constexpr void
     isMultiplicationCorrect(coin_number_t multiplier) const;
+
+    static constexpr coin_number_t
+    saturatingSum(coin_number_t fst, coin_number_t snd);
+
+    static constexpr coin_number_t
+    saturatingDifference(coin_number_t fst, coin_number_t snd);
+
+    static constexpr coin_number_t
+    saturatingProduct(coin_number_t fst, coin_number_t snd);
+
+    char *write(char *out) const;
 };
 
 constexpr static Moneybag Solidus = Moneybag{0, 1, 0};
@@ -118,6 +160,82 @@ constexpr Moneybag operator*(const Moneybag::coin_number_t multiplier,
     return Moneybag(moneybag) *= multiplier;
 }
 
+constexpr std::optional<Moneybag>
+Moneybag::checkedAdd(const Moneybag &snd) const {
+    Moneybag result(0, 0, 0);
+    if (__builtin_add_overflow(livre, snd.livre_number(), &result.livre) |
+        __builtin_add_overflow(solidus, snd.solidus_number(),
+                               &result.solidus) |
+        __builtin_add_overflow(denier, snd.denier_number(), &result.denier)) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+constexpr std::optional<Moneybag>
+Moneybag::checkedSubtract(const Moneybag &snd) const {
+    Moneybag result(0, 0, 0);
+    if (__builtin_sub_overflow(livre, snd.livre_number(), &result.livre) |
+        __builtin_sub_overflow(solidus, snd.solidus_number(),
+                               &result.solidus) |
+        __builtin_sub_overflow(denier, snd.denier_number(), &result.denier)) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+constexpr std::optional<Moneybag>
+Moneybag::checkedMultiply(const coin_number_t multiplier) const {
+    Moneybag result(0, 0, 0);
+    if (__builtin_mul_overflow(livre, multiplier, &result.livre) |
+        __builtin_mul_overflow(solidus, multiplier, &result.solidus) |
+        __builtin_mul_overflow(denier, multiplier, &result.denier)) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+constexpr Moneybag::coin_number_t
+Moneybag::saturatingSum(const coin_number_t fst, const coin_number_t snd) {
+    coin_number_t result = 0;
+    return __builtin_add_overflow(fst, snd, &result) ? UINT64_MAX : result;
+}
+
+constexpr Moneybag::coin_number_t
+Moneybag::saturatingDifference(const coin_number_t fst,
+                               const coin_number_t snd) {
+    coin_number_t result = 0;
+    return __builtin_sub_overflow(fst, snd, &result) ? 0 : result;
+}
+
+constexpr Moneybag::coin_number_t
+Moneybag::saturatingProduct(const coin_number_t fst,
+                            const coin_number_t snd) {
+    coin_number_t result = 0;
+    return __builtin_mul_overflow(fst, snd, &result) ? UINT64_MAX : result;
+}
+
+constexpr Moneybag
+Moneybag::saturatingAdd(const Moneybag &snd) const {
+    return Moneybag(saturatingSum(livre, snd.livre_number()),
+                    saturatingSum(solidus, snd.solidus_number()),
+                    saturatingSum(denier, snd.denier_number()));
+}
+
+constexpr Moneybag
+Moneybag::saturatingSubtract(const Moneybag &snd) const {
+    return Moneybag(saturatingDifference(livre, snd.livre_number()),
+                    saturatingDifference(solidus, snd.solidus_number()),
+                    saturatingDifference(denier, snd.denier_number()));
+}
+
+constexpr Moneybag
+Moneybag::saturatingMultiply(const coin_number_t multiplier) const {
+    return Moneybag(saturatingProduct(livre, multiplier),
+                    saturatingProduct(solidus, multiplier),
+                    saturatingProduct(denier, multiplier));
+}
+
 constexpr bool
 Moneybag::operator==(const Moneybag &snd) const {
     if (solidus == snd.solidus_number() &&
@@ -183,29 +301,81 @@ constexpr void Moneybag::isMultiplicationCorrect(
     }
 }
 
-string Moneybag::toString() const {
-    string s1 = "(" + to_string(livre);
-    if (livre == 1) {
-        s1 += " livr";
-    } else {
-        s1 += " livres";
-    }
+inline char *Moneybag::write(char *out) const {
+    auto append = [&out](std::string_view text) {
+        std::memcpy(out, text.data(), text.size());
+        out += text.size();
+    };
+    *out++ = '(';
+    out = std::to_chars(out, out + 20, livre).ptr;
+    append(livre == 1 ? " livr" : " livres");
+    append(", ");
+    out = std::to_chars(out, out + 20, solidus).ptr;
+    append(solidus == 1 ? " solidus" : " soliduses");
+    append(", ");
+    out = std::to_chars(out, out + 20, denier).ptr;
+    append(denier == 1 ? " denier" : " deniers");
+    *out++ = ')';
+    return out;
+}
 
-    string s2 = ", " + to_string(solidus);
-    if (solidus == 1) {
-        s2 += " solidus";
-    } else {
-        s2 += " soliduses";
+inline std::to_chars_result
+Moneybag::toChars(char *first, char *last) const {
+    if (last - first >= (std::ptrdiff_t) max_chars) {
+        return {write(first), std::errc()};
     }
+    char buffer[max_chars];
+    std::size_t length = write(buffer) - buffer;
+    if ((std::size_t) (last - first) < length) {
+        return {last, std::errc::value_too_large};
+    }
+    std::memcpy(first, buffer, length);
+    return {first + length, std::errc()};
+}
 
-    string s3 = ", " + to_string(denier);
-    if (denier == 1) {
-        s3 += " denier";
-    } else {
-        s3 += " deniers";
+inline std::from_chars_result
+Moneybag::fromChars(const char *first, const char *last, Moneybag &moneybag) {
+    const char *next = first;
+    bool out_of_range = false;
+    auto expect = [&](std::string_view text) {
+        if ((std::size_t) (last - next) < text.size() ||
+            std::memcmp(next, text.data(), text.size()) != 0) {
+            return false;
+        }
+        next += text.size();
+        return true;
+    };
+    auto count = [&](coin_number_t &number, std::string_view one,
+                     std::string_view many) {
+        if (last - next > 1 && next[0] == '0' &&
+            (unsigned) (next[1] - '0') < 10) {
+            return false;
+        }
+        auto [end, error] = std::from_chars(next, last, number);
+        if (error == std::errc::invalid_argument) {
+            return false;
+        }
+        out_of_range |= error == std::errc::result_out_of_range;
+        next = end;
+        return expect(number == 1 && error == std::errc() ? one : many);
+    };
+
+    coin_number_t livre = 0, solidus = 0, denier = 0;
+    if (!(expect("(") && count(livre, " livr", " livres") && expect(", ") &&
+          count(solidus, " solidus", " soliduses") && expect(", ") &&
+          count(denier, " denier", " deniers") && expect(")"))) {
+        return {first, std::errc::invalid_argument};
+    }
+    if (out_of_range) {
+        return {next, std::errc::result_out_of_range};
     }
-    s3 += ")";
-    return s1 + s2 + s3;
+    moneybag = Moneybag(livre, solidus, denier);
+    return {next, std::errc()};
+}
+
+inline string Moneybag::toString() const {
+    char buffer[max_chars];
+    return string(buffer, write(buffer));
 }
 
 constexpr Moneybag::operator bool() const {
@@ -215,9 +385,11 @@ constexpr Moneybag::operator bool() const {
     return true;
 }
 
-std::ostream &
+inline std::ostream &
 operator<<(std::ostream &stream, const Moneybag &moneybag) {
-    return stream << moneybag.toString();
+    char buffer[Moneybag::max_chars];
+    auto [end, error] = moneybag.toChars(buffer, buffer + sizeof buffer);
+    return stream << std::string_view(buffer, end - buffer);
 }
 
 class Value {
@@ -232,6 +404,11 @@ public:
     constexpr explicit Value(const Moneybag::coin_number_t denier)
             : amount(denier) {}
 
+    // Not a constructor, since Value(0) would then be ambiguous.
+    static constexpr Value fromDeniers(__uint128_t deniers);
+
+    constexpr __uint128_t denier_number() const { return amount; }
+
     constexpr Value &
     operator=(const Value &value) = default;
 
@@ -250,6 +427,23 @@ public:
     operator<=>(Moneybag::coin_number_t denier) const;
 
     explicit operator std::string() const;
+
+    // The number of digits in the largest Value.
+    static constexpr std::size_t max_chars = 39;
+
+    std::to_chars_result toChars(char *first, char *last) const;
+
+    // Parses the digits operator std::string produces, so leading zeros
+    // are rejected.
+    static std::from_chars_result
+    fromChars(const char *first, const char *last, Value &value);
+
+private:
+    char *write(char *out) const;
+
+    static bool areEightDigits(const char *first);
+
+    static uint64_t parseEightDigits(const char *first);
 };
 
 constexpr Value::Value(const Moneybag &moneybag) {
@@ -258,6 +452,12 @@ constexpr Value::Value(const Moneybag &moneybag) {
              (__uint128_t) moneybag.denier_number();
 }
 
+constexpr Value Value::fromDeniers(const __uint128_t deniers) {
+    Value value;
+    value.amount = deniers;
+    return value;
+}
+
 constexpr bool Value::operator==(const Value &value) const {
     return amount == value.amount;
 }
@@ -285,15 +485,119 @@ Value::operator<=>(const Moneybag::coin_number_t denier) const {
     }
 }
 
-Value::operator std::string() const {
-    string result;
-    __uint128_t tmp = amount;
-    do {
-        result += (char) (tmp % 10 + '0');
-        tmp /= 10;
-    } while (tmp > 0);
-    std::reverse(result.begin(), result.end());
-    return result;
+// The amount is printed in chunks of 19 digits, so that all but two
+// divisions are done on 64-bit numbers.
+inline char *Value::write(char *out) const {
+    constexpr uint64_t chunk = 10'000'000'000'000'000'000ULL;
+    auto append_chunk = [&out](uint64_t digits) {
+        for (int i = 18; i >= 0; i--) {
+            out[i] = (char) ('0' + digits % 10);
+            digits /= 10;
+        }
+        out += 19;
+    };
+
+    if (amount <= UINT64_MAX) {
+        return std::to_chars(out, out + 20, (uint64_t) amount).ptr;
+    }
+    __uint128_t high = amount / chunk;
+    uint64_t low = (uint64_t) (amount % chunk);
+    if (high <= UINT64_MAX) {
+        out = std::to_chars(out, out + 20, (uint64_t) high).ptr;
+    } else {
+        out = std::to_chars(out, out + 20, (uint64_t) (high / chunk)).ptr;
+        append_chunk((uint64_t) (high % chunk));
+    }
+    append_chunk(low);
+    return out;
+}
+
+inline std::to_chars_result Value::toChars(char *first, char *last) const {
+    if (last - first >= (std::ptrdiff_t) max_chars) {
+        return {write(first), std::errc()};
+    }
+    char buffer[max_chars];
+    std::size_t length = write(buffer) - buffer;
+    if ((std::size_t) (last - first) < length) {
+        return {last, std::errc::value_too_large};
+    }
+    std::memcpy(first, buffer, length);
+    return {first + length, std::errc()};
+}
+
+inline bool Value::areEightDigits(const char *first) {
+    uint64_t chars;
+    std::memcpy(&chars, first, 8);
+    return (chars & 0xf0f0f0f0f0f0f0f0) == 0x3030303030303030 &&
+           ((chars + 0x0606060606060606) & 0xf0f0f0f0f0f0f0f0) ==
+           0x3030303030303030;
+}
+
+// Converts eight ASCII digits at once, with the first one the most
+// significant.
+inline uint64_t Value::parseEightDigits(const char *first) {
+    uint64_t chars;
+    std::memcpy(&chars, first, 8);
+    chars -= 0x3030303030303030;
+    chars = chars * 10 + (chars >> 8);
+    return (((chars & 0x000000ff000000ff) * (100 + (1000000ULL << 32))) +
+            (((chars >> 16) & 0x000000ff000000ff) * (1 + (10000ULL << 32)))) >>
+           32;
+}
+
+// Digits are gathered into 64-bit chunks of up to 19 and only then folded
+// into the 128-bit amount.
+inline std::from_chars_result
+Value::fromChars(const char *first, const char *last, Value &value) {
+    constexpr uint64_t powers_of_ten[] = {
+            1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+            10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+            100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+            100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+            100000000000000000ULL, 1000000000000000000ULL,
+            10000000000000000000ULL};
+    auto is_digit = [](char c) { return (unsigned) (c - '0') < 10; };
+
+    const char *next = first;
+    auto read_chunk = [&]() {
+        const char *end = next + std::min<std::ptrdiff_t>(19, last - next);
+        uint64_t chunk = 0;
+        if constexpr (std::endian::native == std::endian::little) {
+            while (end - next >= 8 && areEightDigits(next)) {
+                chunk = chunk * 100000000 + parseEightDigits(next);
+                next += 8;
+            }
+        }
+        while (next != end && is_digit(*next)) {
+            chunk = chunk * 10 + (uint64_t) (*next - '0');
+            next++;
+        }
+        return chunk;
+    };
+
+    if (next == last || !is_digit(*next) ||
+        (*next == '0' && next + 1 != last && is_digit(next[1]))) {
+        return {first, std::errc::invalid_argument};
+    }
+    __uint128_t amount = read_chunk();
+    bool out_of_range = false;
+    while (next != last && is_digit(*next)) {
+        const char *chunk_begin = next;
+        uint64_t chunk = read_chunk();
+        out_of_range |= __builtin_mul_overflow(
+                amount, powers_of_ten[next - chunk_begin], &amount);
+        out_of_range |= __builtin_add_overflow(amount, chunk, &amount);
+    }
+    if (out_of_range) {
+        return {next, std::errc::result_out_of_range};
+    }
+    value.amount = amount;
+    return {next, std::errc()};
+}
+
+inline Value::operator std::string() const {
+    char buffer[max_chars];
+    return string(buffer, write(buffer));
 }
 
 #endif //MONEYBAG_H
@@ -0,0 +1,259 @@
+// Microbenchmarks of the operations in moneybag.h.
+//
+//     g++ -std=c++20 -O2 moneybag_bench.cc -o moneybag_bench
+//     ./moneybag_bench [--quick]
+//
+// Every operation runs over arrays of random pouches, so that the compiler
+// cannot fold it away, except for the "constexpr" rows, whose operands are
+// known at compile time on purpose. Before timing anything, it checks that
+// fromChars reads back what toString() prints and nothing else, and that
+// ParetoFront::add keeps the same front as paretoFront.
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "moneybag.h"
+#include "moneybag_vector.h"
+#include "pareto_front.h"
+
+namespace {
+    using std::vector;
+    using std::cout;
+    using clock_type = std::chrono::steady_clock;
+
+    // Makes the compiler assume value is read, so that computing it cannot
+    // be optimised out.
+    template <typename T>
+    void keep(const T &value) {
+        asm volatile("" : : "m"(value) : "memory");
+    }
+
+    // Hides value from the optimiser.
+    template <typename T>
+    T opaque(T value) {
+        asm volatile("" : "+m"(value));
+        return value;
+    }
+
+    // Runs op(i) for i in [0, count) and prints the time per call, or per
+    // element when each call handles elements of them.
+    template <typename Op>
+    void measure(const char *name, size_t count, Op op, size_t elements = 1) {
+        auto start = clock_type::now();
+        for (size_t i = 0; i < count; i++) {
+            op(i);
+        }
+        auto end = clock_type::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start)
+                            .count() / count / elements;
+        cout << std::left << std::setw(36) << name << std::right
+             << std::fixed << std::setprecision(2) << std::setw(10) << ns
+             << std::setw(12) << 1e3 / ns << "\n";
+    }
+
+    vector<Moneybag> random_moneybags(std::mt19937_64 &rng, size_t count,
+                                      Moneybag::coin_number_t limit) {
+        vector<Moneybag> ans;
+        ans.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            ans.emplace_back(rng() % limit, rng() % limit, rng() % limit);
+        }
+        return ans;
+    }
+
+    template <typename T>
+    bool parses(std::string_view text, const T &expected) {
+        T parsed(Livre);
+        auto [end, error] = T::fromChars(text.data(),
+                                         text.data() + text.size(), parsed);
+        return error == std::errc() && end == text.data() + text.size() &&
+               parsed == expected;
+    }
+
+    template <typename T>
+    bool rejects(std::string_view text) {
+        T parsed(Livre);
+        auto [end, error] = T::fromChars(text.data(),
+                                         text.data() + text.size(), parsed);
+        return error == std::errc::invalid_argument && end == text.data();
+    }
+
+    bool check_parsing(const vector<Moneybag> &moneybags) {
+        for (const Moneybag &moneybag : moneybags) {
+            Value value(moneybag);
+            if (!parses(moneybag.toString(), moneybag) ||
+                !parses(std::string(value), value)) {
+                std::cerr << "fromChars does not read back "
+                          << moneybag << "\n";
+                return false;
+            }
+        }
+        for (std::string_view text : {"(01 livr, 0 soliduses, 0 deniers)",
+                                      "(1 livr, 00 soliduses, 0 deniers)",
+                                      "(1 livr, 0 soliduses, 007 deniers)"}) {
+            if (!rejects<Moneybag>(text)) {
+                std::cerr << "Moneybag::fromChars accepts " << text << "\n";
+                return false;
+            }
+        }
+        for (std::string_view text : {"00", "01", "000000000000000000001"}) {
+            if (!rejects<Value>(text)) {
+                std::cerr << "Value::fromChars accepts " << text << "\n";
+                return false;
+            }
+        }
+        return parses("(0 livres, 0 soliduses, 0 deniers)", Moneybag(0, 0, 0))
+               && parses("0", Value());
+    }
+
+    // Adds pouches one by one, each greater than some of those before it,
+    // and compares the front with the one computed from scratch.
+    bool check_pareto_front(const vector<Moneybag> &moneybags) {
+        ParetoFront front;
+        front.add(Moneybag(1, 1, 1));
+        front.add(Moneybag(2, 2, 2));
+        front.add(Moneybag(0, 3, 0));
+        front.add(Moneybag(3, 3, 3));
+        if (front.front() != vector<Moneybag>{Moneybag(3, 3, 3)}) {
+            std::cerr << "ParetoFront keeps dominated pouches\n";
+            return false;
+        }
+
+        vector<Moneybag> added;
+        for (const Moneybag &moneybag : moneybags) {
+            Moneybag greater = moneybag + Moneybag(1, 1, 1);
+            front.add(moneybag);
+            front.add(greater);
+            added.push_back(moneybag);
+            added.push_back(greater);
+        }
+        added.push_back(Moneybag(3, 3, 3));
+        if (front.front() != paretoFront(added)) {
+            std::cerr << "ParetoFront::add differs from paretoFront\n";
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+    size_t size = quick ? 1 << 12 : 1 << 16;
+    size_t count = quick ? 1'000'000 : 20'000'000;
+    size_t mask = size - 1;
+
+    std::mt19937_64 rng(2022);
+    vector<Moneybag> small = random_moneybags(rng, size, 1'000'000);
+    vector<Moneybag> other = random_moneybags(rng, size, 1'000'000);
+    vector<Moneybag> huge = random_moneybags(rng, size, UINT64_MAX);
+    vector<Moneybag::coin_number_t> multipliers(size);
+    for (auto &multiplier : multipliers) {
+        multiplier = rng() % 1000 + 1;
+    }
+    vector<Value> values;
+    for (const Moneybag &moneybag : small) {
+        values.emplace_back(moneybag);
+    }
+    if (!check_parsing(small) || !check_parsing(huge) ||
+        !check_pareto_front(vector<Moneybag>(small.begin(),
+                                             small.begin() + 1000))) {
+        return 1;
+    }
+
+    cout << std::left << std::setw(36) << "operation" << std::right
+         << std::setw(10) << "ns/op" << std::setw(12) << "Mops/s" << "\n";
+
+    measure("operator+", count, [&](size_t i) {
+        keep(small[i & mask] + other[i & mask]);
+    });
+    measure("checkedAdd", count, [&](size_t i) {
+        keep(small[i & mask].checkedAdd(other[i & mask]));
+    });
+    measure("saturatingAdd", count, [&](size_t i) {
+        keep(small[i & mask].saturatingAdd(other[i & mask]));
+    });
+    measure("operator+ overflowing (throws)", count / 100, [&](size_t i) {
+        try {
+            keep(huge[i & mask] + huge[(i + 1) & mask]);
+        } catch (const std::out_of_range &) {
+        }
+    });
+    measure("checkedAdd overflowing", count, [&](size_t i) {
+        keep(huge[i & mask].checkedAdd(huge[(i + 1) & mask]));
+    });
+    measure("operator+ and operator-", count, [&](size_t i) {
+        keep(small[i & mask] + other[i & mask] - other[i & mask]);
+    });
+    measure("operator*", count, [&](size_t i) {
+        keep(small[i & mask] * multipliers[i & mask]);
+    });
+    measure("checkedMultiply", count, [&](size_t i) {
+        keep(small[i & mask].checkedMultiply(multipliers[i & mask]));
+    });
+    measure("operator* overflowing (throws)", count / 100, [&](size_t i) {
+        try {
+            keep(huge[i & mask] * multipliers[i & mask]);
+        } catch (const std::out_of_range &) {
+        }
+    });
+    measure("operator* runtime operands", count, [&](size_t) {
+        keep(opaque(Livre) * opaque<Moneybag::coin_number_t>(12) +
+             opaque(Solidus));
+    });
+    measure("operator* constexpr operands", count, [&](size_t) {
+        constexpr Moneybag result = Livre * 12 + Solidus;
+        keep(result);
+    });
+    measure("operator<=>", count, [&](size_t i) {
+        keep(small[i & mask] <=> other[i & mask]);
+    });
+    measure("operator==", count, [&](size_t i) {
+        keep(small[i & mask] == other[i & mask]);
+    });
+    measure("Value(Moneybag)", count, [&](size_t i) {
+        keep(Value(small[i & mask]));
+    });
+    measure("Value(Moneybag) constexpr", count, [&](size_t) {
+        constexpr Value result(Livre * 3 + Denier);
+        keep(result);
+    });
+    measure("Value operator<=>", count, [&](size_t i) {
+        keep(values[i & mask] <=> values[(i + 1) & mask]);
+    });
+    measure("toString", count / 10, [&](size_t i) {
+        keep(small[i & mask].toString());
+    });
+    measure("Moneybag::toChars", count / 10, [&](size_t i) {
+        char buffer[Moneybag::max_chars];
+        keep(small[i & mask].toChars(buffer, buffer + sizeof buffer));
+        keep(buffer);
+    });
+    measure("Value operator std::string", count / 10, [&](size_t i) {
+        keep(std::string(values[i & mask]));
+    });
+    measure("Value::toChars", count / 10, [&](size_t i) {
+        char buffer[Value::max_chars];
+        keep(values[i & mask].toChars(buffer, buffer + sizeof buffer));
+        keep(buffer);
+    });
+
+    MoneybagVector fst, snd;
+    for (size_t i = 0; i < size; i++) {
+        fst.push_back(small[i]);
+        snd.push_back(other[i]);
+    }
+    measure("MoneybagVector add and subtract", count / size, [&](size_t) {
+        keep(fst.add(snd));
+        keep(fst.subtract(snd));
+    }, size);
+    measure("MoneybagVector multiply", count / size, [&](size_t) {
+        keep(fst.multiply(opaque<Moneybag::coin_number_t>(1)));
+    }, size);
+
+    return 0;
+}
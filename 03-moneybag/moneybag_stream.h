@@ -0,0 +1,273 @@
+#ifndef MONEYBAG_STREAM_H
+#define MONEYBAG_STREAM_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "moneybag.h"
+#include "moneybag_vector.h"
+
+// Binary format of a stream of moneybags: the five bytes "MBAG\1" followed
+// by the livre, solidus and denier counts of each moneybag in turn, each as
+// an LEB128 varint (seven bits per byte, lowest first, high bit set on all
+// but the last byte). Counts below 128 take a single byte, so a pouch with
+// small counts takes three bytes instead of 24.
+
+namespace details {
+    constexpr char stream_magic[] = {'M', 'B', 'A', 'G', 1};
+
+    // Longest varint of a 64-bit number.
+    constexpr std::size_t max_varint = 10;
+
+    // Most moneybags MoneybagReader::readAll adds to the arrays at once.
+    constexpr std::size_t read_chunk = 1 << 16;
+
+    inline char *writeVarint(char *out, Moneybag::coin_number_t number) {
+        while (number >= 0x80) {
+            *out++ = (char) (number | 0x80);
+            number >>= 7;
+        }
+        *out++ = (char) number;
+        return out;
+    }
+
+    // Returns nullptr if the varint is cut off by last or does not fit in
+    // 64 bits.
+    inline const char *readVarint(const char *first, const char *last,
+                                  Moneybag::coin_number_t &number) {
+        number = 0;
+        for (std::size_t i = 0; i < max_varint && first != last; i++) {
+            auto byte = (unsigned char) *first++;
+            if (i == max_varint - 1 && byte > 1) {
+                return nullptr;
+            }
+            number |= (Moneybag::coin_number_t) (byte & 0x7f) << (7 * i);
+            if (byte < 0x80) {
+                return first;
+            }
+        }
+        return nullptr;
+    }
+}
+
+class MoneybagWriter {
+public:
+    // Writes the header right away.
+    explicit MoneybagWriter(std::ostream &stream);
+
+    MoneybagWriter(const MoneybagWriter &) = delete;
+
+    MoneybagWriter &operator=(const MoneybagWriter &) = delete;
+
+    ~MoneybagWriter() { flush(); }
+
+    void write(const Moneybag &moneybag);
+
+    void write(const MoneybagVector &moneybags);
+
+    void flush();
+
+private:
+    static constexpr std::size_t buffer_size = 1 << 12;
+
+    std::ostream &stream;
+    char buffer[buffer_size];
+    std::size_t used = 0;
+};
+
+inline MoneybagWriter::MoneybagWriter(std::ostream &stream) : stream(stream) {
+    std::memcpy(buffer, details::stream_magic, sizeof details::stream_magic);
+    used = sizeof details::stream_magic;
+}
+
+inline void MoneybagWriter::write(const Moneybag &moneybag) {
+    if (buffer_size - used < 3 * details::max_varint) {
+        flush();
+    }
+    char *out = buffer + used;
+    out = details::writeVarint(out, moneybag.livre_number());
+    out = details::writeVarint(out, moneybag.solidus_number());
+    out = details::writeVarint(out, moneybag.denier_number());
+    used = out - buffer;
+}
+
+inline void MoneybagWriter::write(const MoneybagVector &moneybags) {
+    for (std::size_t i = 0; i < moneybags.size(); i++) {
+        if (buffer_size - used < 3 * details::max_varint) {
+            flush();
+        }
+        char *out = buffer + used;
+        out = details::writeVarint(out, moneybags.livres()[i]);
+        out = details::writeVarint(out, moneybags.soliduses()[i]);
+        out = details::writeVarint(out, moneybags.deniers()[i]);
+        used = out - buffer;
+    }
+}
+
+inline void MoneybagWriter::flush() {
+    stream.write(buffer, (std::streamsize) used);
+    used = 0;
+}
+
+// Reads moneybags from a stream in memory, which must start with the
+// header. Malformed data makes it throw std::invalid_argument.
+class MoneybagReader {
+public:
+    MoneybagReader(const char *first, const char *last);
+
+    // Returns false at the end of the stream.
+    bool next(Moneybag &moneybag);
+
+    // Appends all remaining moneybags to moneybags.
+    void readAll(MoneybagVector &moneybags);
+
+private:
+    const char *position;
+    const char *last;
+
+    const char *read(Moneybag::coin_number_t &number) const;
+};
+
+inline MoneybagReader::MoneybagReader(const char *first, const char *last)
+        : position(first), last(last) {
+    if ((std::size_t) (last - first) < sizeof details::stream_magic ||
+        std::memcmp(first, details::stream_magic,
+                    sizeof details::stream_magic) != 0) {
+        throw std::invalid_argument("Not a moneybag stream.");
+    }
+    position += sizeof details::stream_magic;
+}
+
+inline const char *
+MoneybagReader::read(Moneybag::coin_number_t &number) const {
+    const char *next = details::readVarint(position, last, number);
+    if (next == nullptr) {
+        throw std::invalid_argument("Malformed moneybag stream.");
+    }
+    return next;
+}
+
+inline bool MoneybagReader::next(Moneybag &moneybag) {
+    if (position == last) {
+        return false;
+    }
+    Moneybag::coin_number_t livre, solidus, denier;
+    position = read(livre);
+    position = read(solidus);
+    position = read(denier);
+    moneybag = Moneybag(livre, solidus, denier);
+    return true;
+}
+
+// Every moneybag takes at least three bytes, which bounds how many are left.
+// The arrays reserve room for that many, which costs no memory until it is
+// written, and grow within it a chunk at a time, so that moneybags are
+// decoded straight into them. When counts are longer and most of the room
+// is left unused, it is given back at the end. Three counts below 128 in
+// a row are recognised with a single test and decoded without a loop.
+inline void MoneybagReader::readAll(MoneybagVector &moneybags) {
+    std::size_t size = moneybags.size();
+    // One more than the bound, for the counts read before the stream turns
+    // out to be cut off.
+    const std::size_t reserved = size + (last - position) / 3 + 1;
+    moneybags.reserve(reserved);
+    auto trim = [&] {
+        moneybags.resize(size);
+        if (size < reserved / 2) {
+            moneybags.shrink_to_fit();
+        }
+    };
+    try {
+        while (position != last) {
+            std::size_t end = size + std::min<std::size_t>(
+                    details::read_chunk, (last - position) / 3 + 1);
+            moneybags.resize(end);
+            Moneybag::coin_number_t *livre = moneybags.livres();
+            Moneybag::coin_number_t *solidus = moneybags.soliduses();
+            Moneybag::coin_number_t *denier = moneybags.deniers();
+
+            while (position != last && size != end) {
+                if (last - position >= 3 &&
+                    ((position[0] | position[1] | position[2]) & 0x80) == 0) {
+                    livre[size] = (unsigned char) position[0];
+                    solidus[size] = (unsigned char) position[1];
+                    denier[size] = (unsigned char) position[2];
+                    position += 3;
+                } else {
+                    position = read(livre[size]);
+                    position = read(solidus[size]);
+                    position = read(denier[size]);
+                }
+                size++;
+            }
+        }
+    } catch (...) {
+        trim();
+        throw;
+    }
+    trim();
+}
+
+// A file of moneybags mapped into memory, so that it can be read without
+// loading it first. Throws std::system_error if it cannot be mapped.
+class MappedMoneybagFile {
+public:
+    explicit MappedMoneybagFile(const std::string &path);
+
+    MappedMoneybagFile(const MappedMoneybagFile &) = delete;
+
+    MappedMoneybagFile &operator=(const MappedMoneybagFile &) = delete;
+
+    ~MappedMoneybagFile();
+
+    MoneybagReader reader() const {
+        return MoneybagReader(data, data + size);
+    }
+
+private:
+    const char *data = nullptr;
+    std::size_t size = 0;
+};
+
+inline MappedMoneybagFile::MappedMoneybagFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), path);
+    }
+    size = info.st_size;
+
+    // mmap cannot map an empty file; an empty reader sees a missing header.
+    if (size > 0) {
+        void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), path);
+        }
+        madvise(address, size, MADV_SEQUENTIAL);
+        data = (const char *) address;
+    }
+    close(fd);
+}
+
+inline MappedMoneybagFile::~MappedMoneybagFile() {
+    if (data != nullptr) {
+        munmap((void *) data, size);
+    }
+}
+
+#endif //MONEYBAG_STREAM_H
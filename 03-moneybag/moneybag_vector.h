@@ -0,0 +1,210 @@
+#ifndef MONEYBAG_VECTOR_H
+#define MONEYBAG_VECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+#include "moneybag.h"
+
+// Moneybags stored as three separate arrays of coin counts. Element-wise
+// kernels are plain loops over contiguous arrays. Instead of throwing per
+// element they return the index of the first element that would overflow
+// (or underflow), leaving the vector unchanged in that case.
+class MoneybagVector {
+public:
+    using coin_number_t = Moneybag::coin_number_t;
+    using size_type = std::size_t;
+
+    MoneybagVector() = default;
+
+    explicit MoneybagVector(size_type size) : livre(size),
+                                              solidus(size),
+                                              denier(size) {}
+
+    size_type size() const { return livre.size(); }
+
+    bool empty() const { return livre.empty(); }
+
+    void reserve(size_type capacity);
+
+    void resize(size_type size);
+
+    void clear();
+
+    void shrink_to_fit();
+
+    void push_back(const Moneybag &moneybag);
+
+    Moneybag operator[](size_type index) const;
+
+    void set(size_type index, const Moneybag &moneybag);
+
+    const coin_number_t *livres() const { return livre.data(); }
+
+    const coin_number_t *soliduses() const { return solidus.data(); }
+
+    const coin_number_t *deniers() const { return denier.data(); }
+
+    coin_number_t *livres() { return livre.data(); }
+
+    coin_number_t *soliduses() { return solidus.data(); }
+
+    coin_number_t *deniers() { return denier.data(); }
+
+    std::optional<size_type> add(const MoneybagVector &snd);
+
+    std::optional<size_type> subtract(const MoneybagVector &snd);
+
+    std::optional<size_type> multiply(coin_number_t multiplier);
+
+private:
+    std::vector<coin_number_t> livre;
+    std::vector<coin_number_t> solidus;
+    std::vector<coin_number_t> denier;
+
+    void isSizeCorrect(const MoneybagVector &snd) const;
+
+    struct broadcast {
+        coin_number_t value;
+
+        coin_number_t operator[](size_type) const { return value; }
+    };
+
+    // Updates all coins in a single pass, in which operation(x, y, result)
+    // stores x op y in result and returns whether it overflowed, like
+    // __builtin_add_overflow. At the first element with an overflow the
+    // elements before it are rolled back with inverse and its index is
+    // returned.
+    template <typename Operand, typename Operation, typename Inverse>
+    std::optional<size_type> transform(const Operand (&snd)[3],
+                                       Operation operation, Inverse inverse);
+};
+
+inline void MoneybagVector::reserve(const size_type capacity) {
+    livre.reserve(capacity);
+    solidus.reserve(capacity);
+    denier.reserve(capacity);
+}
+
+inline void MoneybagVector::resize(const size_type size) {
+    livre.resize(size);
+    solidus.resize(size);
+    denier.resize(size);
+}
+
+inline void MoneybagVector::clear() {
+    livre.clear();
+    solidus.clear();
+    denier.clear();
+}
+
+inline void MoneybagVector::shrink_to_fit() {
+    livre.shrink_to_fit();
+    solidus.shrink_to_fit();
+    denier.shrink_to_fit();
+}
+
+inline void MoneybagVector::push_back(const Moneybag &moneybag) {
+    livre.push_back(moneybag.livre_number());
+    solidus.push_back(moneybag.solidus_number());
+    denier.push_back(moneybag.denier_number());
+}
+
+inline Moneybag MoneybagVector::operator[](const size_type index) const {
+    return Moneybag(livre[index], solidus[index], denier[index]);
+}
+
+inline void
+MoneybagVector::set(const size_type index, const Moneybag &moneybag) {
+    livre[index] = moneybag.livre_number();
+    solidus[index] = moneybag.solidus_number();
+    denier[index] = moneybag.denier_number();
+}
+
+inline void MoneybagVector::isSizeCorrect(const MoneybagVector &snd) const {
+    if (size() != snd.size()) {
+        throw std::invalid_argument("MoneybagVector sizes differ.");
+    }
+}
+
+template <typename Operand, typename Operation, typename Inverse>
+std::optional<MoneybagVector::size_type>
+MoneybagVector::transform(const Operand (&snd)[3], Operation operation,
+                          Inverse inverse) {
+    const size_type n = size();
+    coin_number_t *__restrict fst[3] = {livre.data(), solidus.data(),
+                                        denier.data()};
+
+    for (size_type i = 0; i < n; i++) {
+        coin_number_t result[3];
+        if (operation(fst[0][i], snd[0][i], &result[0]) |
+            operation(fst[1][i], snd[1][i], &result[1]) |
+            operation(fst[2][i], snd[2][i], &result[2])) {
+            for (size_type done = 0; done < i; done++) {
+                for (size_t coin = 0; coin < 3; coin++) {
+                    fst[coin][done] = inverse(fst[coin][done],
+                                              snd[coin][done]);
+                }
+            }
+            return i;
+        }
+        for (size_t coin = 0; coin < 3; coin++) {
+            fst[coin][i] = result[coin];
+        }
+    }
+    return std::nullopt;
+}
+
+inline std::optional<MoneybagVector::size_type>
+MoneybagVector::add(const MoneybagVector &snd) {
+    if (&snd == this) {
+        return add(MoneybagVector(snd));
+    }
+    isSizeCorrect(snd);
+    const coin_number_t *operand[3] = {snd.livres(), snd.soliduses(),
+                                       snd.deniers()};
+    return transform(
+            operand,
+            [](coin_number_t x, coin_number_t y, coin_number_t *result) {
+                return __builtin_add_overflow(x, y, result);
+            },
+            [](coin_number_t x, coin_number_t y) { return x - y; });
+}
+
+inline std::optional<MoneybagVector::size_type>
+MoneybagVector::subtract(const MoneybagVector &snd) {
+    if (&snd == this) {
+        return subtract(MoneybagVector(snd));
+    }
+    isSizeCorrect(snd);
+    const coin_number_t *operand[3] = {snd.livres(), snd.soliduses(),
+                                       snd.deniers()};
+    return transform(
+            operand,
+            [](coin_number_t x, coin_number_t y, coin_number_t *result) {
+                return __builtin_sub_overflow(x, y, result);
+            },
+            [](coin_number_t x, coin_number_t y) { return x + y; });
+}
+
+// One division for the whole vector; a count overflows exactly when it is
+// above limit. This is cheaper than __builtin_mul_overflow, which needs
+// the high half of the product. Counts rolled back did not overflow, so
+// dividing restores them exactly, and multiplying by zero never overflows.
+inline std::optional<MoneybagVector::size_type>
+MoneybagVector::multiply(const coin_number_t multiplier) {
+    const broadcast operand[3] = {{multiplier}, {multiplier}, {multiplier}};
+    const coin_number_t limit =
+            multiplier == 0 ? UINT64_MAX : UINT64_MAX / multiplier;
+    return transform(
+            operand,
+            [limit](coin_number_t x, coin_number_t y, coin_number_t *result) {
+                *result = x * y;
+                return x > limit;
+            },
+            [](coin_number_t x, coin_number_t y) { return x / y; });
+}
+
+#endif //MONEYBAG_VECTOR_H
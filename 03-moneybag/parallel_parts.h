@@ -0,0 +1,42 @@
+#ifndef PARALLEL_PARTS_H
+#define PARALLEL_PARTS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace details {
+    // Smallest number of elements worth giving a thread of its own.
+    constexpr std::size_t min_parallel_part = 1 << 16;
+
+    // Splits [0, size) into one range per thread, but none shorter than
+    // min_parallel_part, and returns part(begin, end) for each of them in
+    // order. A single range is handled without starting a thread.
+    template <typename Part>
+    auto mapParts(std::size_t size, Part part)
+            -> std::vector<decltype(part(size, size))> {
+        std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        std::size_t parts = std::min(threads, size / min_parallel_part + 1);
+
+        std::vector<decltype(part(size, size))> results(parts);
+        if (parts == 1) {
+            results[0] = part(0, size);
+            return results;
+        }
+
+        std::vector<std::thread> workers;
+        for (std::size_t index = 0; index < parts; index++) {
+            workers.emplace_back([&, index] {
+                results[index] = part(size * index / parts,
+                                      size * (index + 1) / parts);
+            });
+        }
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        return results;
+    }
+}
+
+#endif //PARALLEL_PARTS_H
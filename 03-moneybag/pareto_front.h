@@ -0,0 +1,116 @@
+#ifndef PARETO_FRONT_H
+#define PARETO_FRONT_H
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <tuple>
+#include <vector>
+#include "moneybag.h"
+
+// The Pareto front of a collection of moneybags is the set of its maximal
+// elements under Moneybag::operator<=>: the pouches no other pouch is
+// greater than. Each appears once, however many times it was given.
+
+// Returns the front of moneybags, in descending order of livres. Runs in
+// O(n log n): pouches are swept in descending lexicographic order, so every
+// pouch which could be greater than the current one has already been seen,
+// and the seen pouches are kept as a staircase of their (solidus, denier)
+// maxima, in which the current one is looked up.
+inline std::vector<Moneybag> paretoFront(std::vector<Moneybag> moneybags) {
+    auto coins = [](const Moneybag &moneybag) {
+        return std::make_tuple(moneybag.livre_number(),
+                               moneybag.solidus_number(),
+                               moneybag.denier_number());
+    };
+    std::sort(moneybags.begin(), moneybags.end(),
+              [&](const Moneybag &fst, const Moneybag &snd) {
+                  return coins(fst) > coins(snd);
+              });
+
+    // Solidus to denier counts, with denier counts decreasing as solidus
+    // counts increase.
+    std::map<Moneybag::coin_number_t, Moneybag::coin_number_t> staircase;
+    std::vector<Moneybag> front;
+    for (const Moneybag &moneybag : moneybags) {
+        Moneybag::coin_number_t solidus = moneybag.solidus_number();
+        Moneybag::coin_number_t denier = moneybag.denier_number();
+
+        auto above = staircase.lower_bound(solidus);
+        if (above != staircase.end() && above->second >= denier) {
+            continue;
+        }
+
+        auto below = staircase.upper_bound(solidus);
+        while (below != staircase.begin() &&
+               std::prev(below)->second <= denier) {
+            below = staircase.erase(std::prev(below));
+        }
+        staircase.emplace(solidus, denier);
+        front.push_back(moneybag);
+    }
+    return front;
+}
+
+// A Pareto front which pouches can be added to one by one. A single pouch
+// is checked against the current front only, in O(F) for F = front size:
+// it is dropped if some member is at least as great, and otherwise replaces
+// the members it is greater than. As the front is kept in descending order
+// of livres, the former are looked for only among members with at least as
+// many livres and the latter among those with at most as many. Pouches that
+// have dropped out are never looked at again.
+class ParetoFront {
+public:
+    void add(const Moneybag &moneybag) {
+        Moneybag::coin_number_t livre = moneybag.livre_number();
+        auto not_fewer = std::partition_point(
+                points.begin(), points.end(), [&](const Moneybag &member) {
+                    return member.livre_number() >= livre;
+                });
+        for (auto it = points.begin(); it != not_fewer; ++it) {
+            if (*it >= moneybag) {
+                return;
+            }
+        }
+
+        auto not_more = std::partition_point(
+                points.begin(), not_fewer, [&](const Moneybag &member) {
+                    return member.livre_number() > livre;
+                });
+        // The erase below invalidates not_more when it starts there.
+        std::size_t first_kept = not_more - points.begin();
+        points.erase(std::remove_if(not_more, points.end(),
+                                    [&](const Moneybag &member) {
+                                        return moneybag > member;
+                                    }),
+                     points.end());
+        points.insert(std::upper_bound(points.begin() + first_kept,
+                                       points.end(), moneybag, descending),
+                      moneybag);
+    }
+
+    // Merges many pouches at once, in O(k log k) for k = F + their number.
+    template <typename Iterator>
+    void add(Iterator first, Iterator last) {
+        points.insert(points.end(), first, last);
+        points = paretoFront(std::move(points));
+    }
+
+    // In descending order of livres.
+    const std::vector<Moneybag> &front() const { return points; }
+
+    std::size_t size() const { return points.size(); }
+
+private:
+    // The order paretoFront returns the front in.
+    static bool descending(const Moneybag &fst, const Moneybag &snd) {
+        return std::make_tuple(fst.livre_number(), fst.solidus_number(),
+                               fst.denier_number()) >
+               std::make_tuple(snd.livre_number(), snd.solidus_number(),
+                               snd.denier_number());
+    }
+
+    std::vector<Moneybag> points;
+};
+
+#endif //PARETO_FRONT_H
@@ -0,0 +1,148 @@
+#ifndef VALUE_SORT_H
+#define VALUE_SORT_H
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <vector>
+#include "moneybag.h"
+#include "parallel_parts.h"
+
+namespace details {
+    // Below this many elements std::stable_sort beats the radix sort.
+    constexpr std::size_t min_radix_sort = 1 << 8;
+
+    constexpr __uint128_t valueKey(const Value &value) {
+        return value.denier_number();
+    }
+
+    constexpr __uint128_t valueKey(const Moneybag &moneybag) {
+        return Value(moneybag).denier_number();
+    }
+
+    // LSD radix sort by valueKey, one byte per pass, for keys with no bits
+    // set above the lowest given number of bytes. Histograms for all passes
+    // are built in a single pass, and bytes that are the same in every key
+    // are skipped. Stable.
+    template <typename Key, typename T>
+    void radixSort(std::vector<T> &items, std::size_t bytes) {
+        std::vector<std::array<std::size_t, 256>> counts(bytes);
+        for (const T &item : items) {
+            Key key = (Key) valueKey(item);
+            for (std::size_t byte = 0; byte < bytes; byte++) {
+                counts[byte][(key >> (8 * byte)) & 0xff]++;
+            }
+        }
+
+        std::vector<T> buffer(items.size(), items.front());
+        for (std::size_t byte = 0; byte < bytes; byte++) {
+            std::array<std::size_t, 256> &count = counts[byte];
+            if (std::find(count.begin(), count.end(), items.size()) !=
+                count.end()) {
+                continue;
+            }
+
+            std::size_t offset = 0;
+            for (std::size_t &bucket : count) {
+                std::size_t size = bucket;
+                bucket = offset;
+                offset += size;
+            }
+            for (const T &item : items) {
+                Key key = (Key) valueKey(item);
+                buffer[count[(key >> (8 * byte)) & 0xff]++] = item;
+            }
+            items.swap(buffer);
+        }
+    }
+
+    // Bytes above the highest set bit of any key are never looked at, and
+    // when that leaves at most eight, keys are handled as 64-bit numbers.
+    template <typename T>
+    void radixSort(std::vector<T> &items) {
+        if (items.size() < min_radix_sort) {
+            std::stable_sort(items.begin(), items.end(),
+                             [](const T &fst, const T &snd) {
+                                 return valueKey(fst) < valueKey(snd);
+                             });
+            return;
+        }
+
+        __uint128_t all_bits = 0;
+        for (const T &item : items) {
+            all_bits |= valueKey(item);
+        }
+        std::size_t bytes = 0;
+        while (bytes < sizeof(__uint128_t) && (all_bits >> (8 * bytes)) != 0) {
+            bytes++;
+        }
+
+        if (bytes <= sizeof(uint64_t)) {
+            radixSort<uint64_t>(items, bytes);
+        } else {
+            radixSort<__uint128_t>(items, bytes);
+        }
+    }
+
+    // The n largest of items, largest first. Each thread keeps the n
+    // largest of its own part in a heap with the smallest of them on top,
+    // so most elements cost one comparison. The candidates of all parts are
+    // then selected from again.
+    template <typename T>
+    std::vector<T> topN(const std::vector<T> &items, std::size_t n) {
+        auto greater = [](const T &fst, const T &snd) {
+            return valueKey(fst) > valueKey(snd);
+        };
+
+        n = std::min(n, items.size());
+        std::vector<std::vector<T>> found = mapParts(
+                items.size(), [&](std::size_t begin, std::size_t end) {
+                    std::vector<T> heap;
+                    for (auto it = items.begin() + begin;
+                         it != items.begin() + end; ++it) {
+                        if (heap.size() < n) {
+                            heap.push_back(*it);
+                            std::push_heap(heap.begin(), heap.end(), greater);
+                        } else if (n > 0 && greater(*it, heap.front())) {
+                            std::pop_heap(heap.begin(), heap.end(), greater);
+                            heap.back() = *it;
+                            std::push_heap(heap.begin(), heap.end(), greater);
+                        }
+                    }
+                    return heap;
+                });
+
+        std::vector<T> ans = std::move(found[0]);
+        for (std::size_t part = 1; part < found.size(); part++) {
+            ans.insert(ans.end(), found[part].begin(), found[part].end());
+        }
+        std::sort(ans.begin(), ans.end(), greater);
+        ans.erase(ans.begin() + n, ans.end());
+        return ans;
+    }
+}
+
+// Sorts in ascending order of value.
+inline void sortValues(std::vector<Value> &values) {
+    details::radixSort(values);
+}
+
+// Sorts in ascending order of Value(moneybag), keeping the order of
+// moneybags of equal value.
+inline void sortByValue(std::vector<Moneybag> &moneybags) {
+    details::radixSort(moneybags);
+}
+
+// The n largest values, largest first.
+inline std::vector<Value>
+topValues(const std::vector<Value> &values, std::size_t n) {
+    return details::topN(values, n);
+}
+
+// The n moneybags of largest value, largest first.
+inline std::vector<Moneybag>
+topByValue(const std::vector<Moneybag> &moneybags, std::size_t n) {
+    return details::topN(moneybags, n);
+}
+
+#endif //VALUE_SORT_H
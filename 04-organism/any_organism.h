@@ -0,0 +1,160 @@
+#ifndef ANY_ORGANISM_H
+#define ANY_ORGANISM_H
+
+#include <cstdint>
+#include <concepts>
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <utility>
+#include "organism.h"
+
+// Organizm, którego nawyki żywieniowe znane są dopiero w czasie wykonania.
+// Zamiast std::variant czterech rodzajów Organism i podwójnego std::visit
+// spotkanie wybiera swój rodzaj jednym odczytem tablicy 4x4 wyznaczonej
+// w czasie kompilacji z details::can_eat i details::is_plant.
+
+template <typename species_t>
+requires std::equality_comparable<species_t>
+class AnyOrganism {
+    species_t species;
+    uint64_t vitality;
+    details::diet_t diet;
+
+    constexpr AnyOrganism(species_t const &sp, uint64_t vital,
+                          details::diet_t diet):
+            species(sp), vitality(vital), diet(diet) {};
+
+    public:
+        template <bool can_eat_meat, bool can_eat_plants>
+        constexpr AnyOrganism(Organism<species_t, can_eat_meat,
+                                       can_eat_plants> const &organism):
+                  species(organism.get_species()),
+                  vitality(organism.get_vitality()),
+                  diet(details::get_diet(can_eat_meat, can_eat_plants)) {};
+
+        constexpr const species_t &get_species() const {
+            return species;
+        }
+
+        constexpr uint64_t get_vitality() const {
+            return vitality;
+        }
+
+        constexpr bool is_dead() const {
+            return vitality == 0;
+        }
+
+        constexpr bool can_eat_meat() const {
+            return details::get_eating_habits(diet).first;
+        }
+
+        constexpr bool can_eat_plants() const {
+            return details::get_eating_habits(diet).second;
+        }
+
+        constexpr bool is_plant() const {
+            return details::is_plant(details::get_eating_habits(diet));
+        }
+
+        // Czy organizm jest rodzaju Organism<species_t, eats_m, eats_p>.
+        template <bool eats_m, bool eats_p>
+        constexpr bool holds() const {
+            return diet == details::get_diet(eats_m, eats_p);
+        }
+
+        template <typename sp_t>
+        requires std::equality_comparable<sp_t>
+        friend constexpr std::tuple<AnyOrganism<sp_t>, AnyOrganism<sp_t>,
+                                    std::optional<AnyOrganism<sp_t>>>
+        encounter(AnyOrganism<sp_t> organism1, AnyOrganism<sp_t> organism2);
+
+        template <typename sp_t, bool sp1_eats_m, bool sp1_eats_p,
+                  std::ranges::input_range Opponents>
+        requires std::same_as<std::ranges::range_value_t<Opponents>,
+                              AnyOrganism<sp_t>>
+        friend constexpr Organism<sp_t, sp1_eats_m, sp1_eats_p>
+        encounter_series(Organism<sp_t, sp1_eats_m, sp1_eats_p> organism1,
+                         Opponents &&opponents);
+
+        template <typename sp_t, std::ranges::input_range Opponents>
+        requires std::same_as<std::ranges::range_value_t<Opponents>,
+                              AnyOrganism<sp_t>>
+        friend constexpr AnyOrganism<sp_t>
+        encounter_series(AnyOrganism<sp_t> organism1, Opponents &&opponents);
+};
+
+// Odpowiednik encounter dla organizmów znanych w czasie wykonania. Spotkanie
+// dwóch roślin, które w encounter się nie skompiluje, tutaj niczego nie
+// zmienia.
+template <typename species_t>
+requires std::equality_comparable<species_t>
+constexpr std::tuple<AnyOrganism<species_t>, AnyOrganism<species_t>,
+                     std::optional<AnyOrganism<species_t>>>
+encounter(AnyOrganism<species_t> organism1,
+          AnyOrganism<species_t> organism2) {
+    using details::encounter_kind;
+
+    encounter_kind kind =
+            details::encounter_table[organism1.diet][organism2.diet];
+
+    // Warunki 2 i 3
+    if (kind == encounter_kind::plants || organism1.is_dead() ||
+        organism2.is_dead()) {
+        return {std::move(organism1), std::move(organism2), std::nullopt};
+    }
+
+    // Warunek 4
+    if (organism1.diet == organism2.diet &&
+        organism1.species == organism2.species) {
+        AnyOrganism<species_t> child(
+                organism1.species,
+                (organism1.vitality + organism2.vitality) / 2,
+                organism1.diet);
+        return {std::move(organism1), std::move(organism2), std::move(child)};
+    }
+
+    details::resolve_encounter(kind, organism1.vitality, organism2.vitality);
+    return {std::move(organism1), std::move(organism2), std::nullopt};
+}
+
+// Seria spotkań z organizmami z zakresu, których rodzaje znane są dopiero
+// w czasie wykonania, liczona jak w encounter_series z organism.h. Spotkania
+// roślin niczego nie zmieniają.
+template <typename species_t, bool sp1_eats_m, bool sp1_eats_p,
+          std::ranges::input_range Opponents>
+requires std::same_as<std::ranges::range_value_t<Opponents>,
+                      AnyOrganism<species_t>>
+    constexpr Organism<species_t, sp1_eats_m, sp1_eats_p>
+    encounter_series(Organism<species_t, sp1_eats_m, sp1_eats_p> organism1,
+                     Opponents &&opponents) {
+        constexpr details::diet_t diet1 =
+                details::get_diet(sp1_eats_m, sp1_eats_p);
+
+        uint64_t vitality = organism1.get_vitality();
+        for (AnyOrganism<species_t> const &opponent : opponents) {
+            vitality = details::vitality_after_encounter(
+                    diet1, opponent.diet,
+                    organism1.get_species() == opponent.get_species(),
+                    vitality, opponent.get_vitality());
+        }
+        return Organism<species_t, sp1_eats_m, sp1_eats_p>
+               (organism1.get_species(), vitality);
+    }
+
+template <typename species_t, std::ranges::input_range Opponents>
+requires std::same_as<std::ranges::range_value_t<Opponents>,
+                      AnyOrganism<species_t>>
+    constexpr AnyOrganism<species_t>
+    encounter_series(AnyOrganism<species_t> organism1,
+                     Opponents &&opponents) {
+        for (AnyOrganism<species_t> const &opponent : opponents) {
+            organism1.vitality = details::vitality_after_encounter(
+                    organism1.diet, opponent.diet,
+                    organism1.species == opponent.species,
+                    organism1.vitality, opponent.vitality);
+        }
+        return organism1;
+    }
+
+#endif // ANY_ORGANISM_H
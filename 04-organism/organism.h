@@ -1,8 +1,11 @@
 #ifndef ORGANISM_H
 #define ORGANISM_H
 
+#include <array>
 #include <optional>
+#include <ranges>
 #include <tuple>
+#include <type_traits>
 #include <cstdint>
 
 template <typename species_t, bool can_eat_meat, bool can_eat_plants>
@@ -41,8 +44,6 @@ class Organism {
                                       const &opponent) {
             uint64_t this_vitality = vitality;
             uint64_t opp_vitality = opponent.get_vitality();
-            species_t this_species = species;
-            species_t opp_species = opponent.get_species();
 
             if (this_vitality > opp_vitality) {
                 this_vitality += opp_vitality / 2;
@@ -57,10 +58,10 @@ class Organism {
 
             return std::tuple{
                 Organism<species_t, can_eat_meat, can_eat_plants>
-                (this_species, this_vitality),
+                (species, this_vitality),
 
                 Organism<species_t, true, eating_plants>
-                (opp_species, opp_vitality),
+                (opponent.get_species(), opp_vitality),
 
                 std::nullopt              
             };
@@ -70,15 +71,13 @@ class Organism {
                                           const &plant) {
             uint64_t this_vitality = vitality += plant.get_vitality();
             uint64_t plant_vitality = 0;
-            species_t this_species = species;
-            species_t plant_species = plant.get_species();
 
             return std::tuple{
                 Organism<species_t, can_eat_meat, can_eat_plants>
-                (this_species, this_vitality),
+                (species, this_vitality),
 
                 Organism<species_t, false, false>
-                (plant_species, plant_vitality),
+                (plant.get_species(), plant_vitality),
 
                 std::nullopt
             };
@@ -89,8 +88,6 @@ class Organism {
                                     const &being_eaten) {
             uint64_t this_vitality = vitality;
             uint64_t eaten_vitality = being_eaten.get_vitality();
-            species_t this_species = species;
-            species_t eaten_species = being_eaten.get_species();
 
             // Zjadamy
             if (this_vitality > eaten_vitality) {
@@ -102,10 +99,10 @@ class Organism {
 
             return std::tuple{
                 Organism<species_t, can_eat_meat, can_eat_plants>
-                (this_species, this_vitality),
+                (species, this_vitality),
 
                 Organism<species_t, eating_meat, eating_plants>
-                (eaten_species, eaten_vitality),
+                (being_eaten.get_species(), eaten_vitality),
 
                 std::nullopt
             };
@@ -137,21 +134,126 @@ namespace details {
                (is_plant(eaten) && eater.second);
     }
 
-    template <typename species_t, bool sp1_eats_m, bool sp1_eats_p, 
-          typename Head, typename ... Tail>
-    constexpr Organism<species_t, sp1_eats_m, sp1_eats_p>
-    encounter_series_helper(Organism<species_t, sp1_eats_m, sp1_eats_p> organism1,
-                            Head head, Tail ... tail) {
-
-        if constexpr (sizeof...(tail) == 0) {
-            return get<0>(encounter(organism1, head));
+    // Rodzaj spotkania dwóch żywych organizmów różnych gatunków (lub o
+    // różnych nawykach żywieniowych), wyznaczony tak samo jak w encounter.
+    // Pozwala stosować te same reguły do organizmów znanych dopiero
+    // w czasie wykonania.
+    enum class encounter_kind : uint8_t {
+        plants,             // Warunek 2 - spotkanie roślin jest niedozwolone
+        nothing,            // Warunek 5
+        fight,              // Warunek 6
+        first_eats_plant,   // Warunek 7
+        second_eats_plant,
+        first_eats,         // Warunek 8
+        second_eats
+    };
+
+    constexpr encounter_kind get_encounter_kind(std::pair<bool, bool> org1,
+                                                std::pair<bool, bool> org2) {
+        if (is_plant(org1) && is_plant(org2)) {
+            return encounter_kind::plants;
+        } else if (!can_eat(org1, org2) && !can_eat(org2, org1)) {
+            return encounter_kind::nothing;
+        } else if (can_eat(org1, org2) && can_eat(org2, org1)) {
+            return encounter_kind::fight;
+        } else if (can_eat(org1, org2) && is_plant(org2)) {
+            return encounter_kind::first_eats_plant;
+        } else if (can_eat(org2, org1) && is_plant(org1)) {
+            return encounter_kind::second_eats_plant;
+        } else if (can_eat(org1, org2)) {
+            return encounter_kind::first_eats;
         } else {
-            Organism<species_t, sp1_eats_m, sp1_eats_p> result = 
-            get<0>(encounter(organism1, head));
+            return encounter_kind::second_eats;
+        }
+    }
+
+    // Zmienia witalności dwóch żywych organizmów tak, jak spotkanie
+    // rodzaju kind (Warunki 5-8). Przy organizmach losowanych w czasie
+    // wykonania rodzaj spotkania i zwycięzca są nieprzewidywalne dla
+    // procesora, więc wynik wybierany jest maskami bitowymi zamiast skoków.
+    constexpr void resolve_encounter(encounter_kind kind, uint64_t &vitality1,
+                                     uint64_t &vitality2) {
+        bool fight = kind == encounter_kind::fight;
+        bool first_eats_plant = kind == encounter_kind::first_eats_plant;
+        bool second_eats_plant = kind == encounter_kind::second_eats_plant;
+        bool first_wins = first_eats_plant |
+                ((fight | (kind == encounter_kind::first_eats)) &
+                 (vitality1 > vitality2));
+        bool second_wins = second_eats_plant |
+                ((fight | (kind == encounter_kind::second_eats)) &
+                 (vitality2 > vitality1));
+        bool both_die = fight & (vitality1 == vitality2);
+
+        // Roślinę zjada się w całości, zwierzę w połowie.
+        uint64_t gain1 = vitality2 >> !first_eats_plant;
+        uint64_t gain2 = vitality1 >> !second_eats_plant;
+
+        uint64_t wins1 = -(uint64_t) first_wins;
+        uint64_t wins2 = -(uint64_t) second_wins;
+        uint64_t dies = -(uint64_t) both_die;
+        uint64_t result1 = (wins1 & (vitality1 + gain1)) |
+                           (~wins1 & ~wins2 & ~dies & vitality1);
+        uint64_t result2 = (wins2 & (vitality2 + gain2)) |
+                           (~wins1 & ~wins2 & ~dies & vitality2);
+        vitality1 = result1;
+        vitality2 = result2;
+    }
+
+    // Nawyki żywieniowe zapisane na dwóch bitach: jedzenie mięsa i roślin.
+    using diet_t = uint8_t;
+
+    constexpr diet_t get_diet(bool eats_meat, bool eats_plants) {
+        return (diet_t) (eats_meat << 1 | eats_plants);
+    }
+
+    constexpr std::pair<bool, bool> get_eating_habits(diet_t diet) {
+        return {(diet & 2) != 0, (diet & 1) != 0};
+    }
 
-            return encounter_series_helper(result, tail...);
+    // Rodzaje spotkań dla wszystkich par nawyków żywieniowych.
+    constexpr auto make_encounter_table() {
+        std::array<std::array<encounter_kind, 4>, 4> table{};
+        for (diet_t diet1 = 0; diet1 < 4; diet1++) {
+            for (diet_t diet2 = 0; diet2 < 4; diet2++) {
+                table[diet1][diet2] =
+                        get_encounter_kind(get_eating_habits(diet1),
+                                           get_eating_habits(diet2));
+            }
         }
+        return table;
+    }
 
+    constexpr auto encounter_table = make_encounter_table();
+
+    // Nawyki żywieniowe typu Organism.
+    template <typename T>
+    struct organism_traits {
+        static constexpr bool is_organism = false;
+    };
+
+    template <typename species_t, bool eats_m, bool eats_p>
+    struct organism_traits<Organism<species_t, eats_m, eats_p>> {
+        static constexpr bool is_organism = true;
+        static constexpr bool eats_meat = eats_m;
+        static constexpr bool eats_plants = eats_p;
+    };
+
+    // Witalność pierwszego organizmu po spotkaniu z drugim, bez tworzenia
+    // krotki wyników spotkania.
+    constexpr uint64_t vitality_after_encounter(diet_t diet1, diet_t diet2,
+                                                bool same_species,
+                                                uint64_t vitality1,
+                                                uint64_t vitality2) {
+        encounter_kind kind = encounter_table[diet1][diet2];
+
+        // Warunki 2, 3 i 4 nie zmieniają pierwszego organizmu.
+        if (kind == encounter_kind::plants || vitality1 == 0 ||
+            vitality2 == 0 || (diet1 == diet2 && same_species)) {
+            return vitality1;
+        }
+
+        resolve_encounter(kind, vitality1, vitality2);
+        return vitality1;
     }
 }
 
@@ -241,7 +343,44 @@ template <typename species_t, bool sp1_eats_m, bool sp1_eats_p,
     constexpr Organism<species_t, sp1_eats_m, sp1_eats_p>
     encounter_series(Organism<species_t, sp1_eats_m, sp1_eats_p> organism1,
                      Args ... args) {
-        return details::encounter_series_helper(organism1, args...);
+        ((organism1 = std::get<0>(encounter(organism1, args))), ...);
+        return organism1;
+    }
+
+// Seria spotkań z kolejnymi organizmami z zakresu, wszystkimi tego samego
+// rodzaju. Liczona jest tylko witalność pierwszego organizmu, bez krotek
+// wyników i kopii gatunków.
+template <typename species_t, bool sp1_eats_m, bool sp1_eats_p,
+          std::ranges::input_range Opponents>
+requires details::organism_traits<
+                 std::ranges::range_value_t<Opponents>>::is_organism
+    constexpr Organism<species_t, sp1_eats_m, sp1_eats_p>
+    encounter_series(Organism<species_t, sp1_eats_m, sp1_eats_p> organism1,
+                     Opponents &&opponents) {
+        using opponent_t = std::ranges::range_value_t<Opponents>;
+        using traits = details::organism_traits<opponent_t>;
+        static_assert(std::is_same_v<opponent_t,
+                                     Organism<species_t, traits::eats_meat,
+                                              traits::eats_plants>>);
+
+        // Warunek 2
+        static_assert(sp1_eats_m || sp1_eats_p ||
+                      traits::eats_meat || traits::eats_plants);
+
+        constexpr details::diet_t diet1 =
+                details::get_diet(sp1_eats_m, sp1_eats_p);
+        constexpr details::diet_t diet2 =
+                details::get_diet(traits::eats_meat, traits::eats_plants);
+
+        uint64_t vitality = organism1.get_vitality();
+        for (opponent_t const &opponent : opponents) {
+            vitality = details::vitality_after_encounter(
+                    diet1, diet2,
+                    organism1.get_species() == opponent.get_species(),
+                    vitality, opponent.get_vitality());
+        }
+        return Organism<species_t, sp1_eats_m, sp1_eats_p>
+               (organism1.get_species(), vitality);
     }
 
 
@@ -0,0 +1,417 @@
+#ifndef POPULATION_H
+#define POPULATION_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "organism.h"
+#include "species.h"
+
+// Populacja organizmów znanych dopiero w czasie wykonania, przechowywana
+// kolumnami (nawyki żywieniowe, numer gatunku, witalność), tak żeby
+// spotkanie czytało tylko kilka bajtów każdego z organizmów. Spotkania
+// podlegają dokładnie tym samym regułom co encounter z organism.h.
+
+namespace details {
+    // Liczba z przedziału [0, bound) z 64 losowych bitów.
+    constexpr uint64_t scale(uint64_t random, uint64_t bound) {
+        return (uint64_t) (((__uint128_t) random * bound) >> 64);
+    }
+
+    constexpr uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+        return x ^ (x >> 31);
+    }
+
+    // Losowe bity wyznaczone przez strumień i numer losowania, bez stanu
+    // przechodzącego między losowaniami, więc można je liczyć w dowolnej
+    // kolejności i na dowolnym wątku.
+    constexpr uint64_t counter_random(uint64_t stream, uint64_t counter) {
+        return mix(mix(stream) + counter * 0x9e3779b97f4a7c15);
+    }
+
+    // Zastępuje indeks gatunków, których nie da się haszować.
+    struct no_species_index {};
+
+    // Liczba par w jednym kawałku rundy.
+    constexpr std::size_t round_chunk = 1 << 12;
+
+    // Najmniej kawałków na wątek, żeby opłacało się go uruchomić.
+    constexpr std::size_t min_round_chunks = 4;
+
+    // Przedział [begin, end) numerów kawałków wątku, zapisany w jednej
+    // liczbie, żeby właściciel, który bierze kawałki z początku, i wątki,
+    // które podbierają je z końca, zmieniały go jednym compare_exchange.
+    class alignas(64) chunk_range {
+        std::atomic<uint64_t> range{0};
+
+        static constexpr uint64_t pack(uint32_t begin, uint32_t end) {
+            return (uint64_t) begin << 32 | end;
+        }
+
+        public:
+            void reset(uint32_t begin, uint32_t end) {
+                range.store(pack(begin, end), std::memory_order_relaxed);
+            }
+
+            std::optional<uint32_t> take() {
+                uint64_t current = range.load(std::memory_order_relaxed);
+                while (true) {
+                    uint32_t begin = current >> 32, end = (uint32_t) current;
+                    if (begin == end) {
+                        return std::nullopt;
+                    }
+                    if (range.compare_exchange_weak(
+                            current, pack(begin + 1, end),
+                            std::memory_order_relaxed)) {
+                        return begin;
+                    }
+                }
+            }
+
+            // Przejmuje drugą połowę kawałków victim; ten przedział musi
+            // być pusty.
+            bool steal(chunk_range &victim) {
+                uint64_t current = victim.range.load(std::memory_order_relaxed);
+                while (true) {
+                    uint32_t begin = current >> 32, end = (uint32_t) current;
+                    if (begin == end) {
+                        return false;
+                    }
+                    uint32_t middle = end - (end - begin + 1) / 2;
+                    if (victim.range.compare_exchange_weak(
+                            current, pack(begin, middle),
+                            std::memory_order_relaxed)) {
+                        reset(middle, end);
+                        return true;
+                    }
+                }
+            }
+    };
+}
+
+template <typename species_t>
+requires std::equality_comparable<species_t>
+class Population {
+    using species_id_t = uint32_t;
+
+    std::vector<details::diet_t> diets;
+    std::vector<species_id_t> species_ids;
+    std::vector<uint64_t> vitalities;
+
+    // Gatunki w kolejności pojawienia się; numer gatunku to indeks w tym
+    // wektorze.
+    std::vector<species_t> species_list;
+
+    // Numery gatunków, jeśli da się je haszować; inaczej gatunek szukany
+    // jest po kolei w species_list.
+    [[no_unique_address]] std::conditional_t<
+            hashable_species<species_t>,
+            std::unordered_map<species_t, species_id_t>,
+            details::no_species_index> species_index;
+
+    species_id_t get_species_id(species_t const &species);
+
+    void push(details::diet_t diet, species_id_t species_id,
+              uint64_t vitality);
+
+    // Spotkanie bez dopisywania potomka; zwraca, czy się urodził, a jego
+    // witalność zapisuje w offspring_vitality.
+    bool meet(std::size_t index1, std::size_t index2,
+              uint64_t &offspring_vitality);
+
+    // Spotkania par z kawałka chunk rundy; potomków dopisuje do offspring
+    // jako pary (indeks rodzica, witalność).
+    void meet_chunk(std::vector<std::size_t> const &order, std::size_t chunk,
+                    std::vector<std::pair<std::size_t, uint64_t>> &offspring);
+
+    public:
+        template <bool can_eat_meat, bool can_eat_plants>
+        std::size_t add(Organism<species_t, can_eat_meat, can_eat_plants>
+                                 const &organism) {
+            push(details::get_diet(can_eat_meat, can_eat_plants),
+                 get_species_id(organism.get_species()),
+                 organism.get_vitality());
+            return size() - 1;
+        }
+
+        std::size_t size() const {
+            return vitalities.size();
+        }
+
+        void reserve(std::size_t capacity);
+
+        species_t const &get_species(std::size_t index) const {
+            return species_list[species_ids[index]];
+        }
+
+        uint64_t get_vitality(std::size_t index) const {
+            return vitalities[index];
+        }
+
+        bool can_eat_meat(std::size_t index) const {
+            return details::get_eating_habits(diets[index]).first;
+        }
+
+        bool can_eat_plants(std::size_t index) const {
+            return details::get_eating_habits(diets[index]).second;
+        }
+
+        bool is_dead(std::size_t index) const {
+            return vitalities[index] == 0;
+        }
+
+        // Odpowiednik encounter dla organizmów o podanych indeksach: ich
+        // witalności zmieniają się tak, jak w zwróconej krotce, a potomek
+        // jest dopisywany na koniec populacji. Spotkanie dwóch roślin, które
+        // w encounter się nie skompiluje, tutaj niczego nie zmienia.
+        void encounter(std::size_t index1, std::size_t index2);
+
+        // Losuje count par różnych organizmów i przeprowadza ich spotkania
+        // po kolei. Generator musi zwracać 64 losowe bity, np.
+        // std::mt19937_64.
+        template <typename Generator>
+        void encounters(std::size_t count, Generator &generator);
+
+        // Runda spotkań: organizmy łączone są w losowe rozłączne pary (przy
+        // nieparzystej liczebności jeden zostaje bez pary), a spotkania par
+        // odbywają się na thread_count wątkach (0 - na tylu, ile sprzęt
+        // obsługuje). Potomkowie dopisywani są po rundzie w kolejności par.
+        // Losowość zależy tylko od seed, więc wynik jest identyczny przy
+        // każdej liczbie wątków.
+        void encounter_round(uint64_t seed, unsigned thread_count = 0);
+
+        // Usuwa martwe organizmy, zachowując kolejność pozostałych.
+        void remove_dead();
+};
+
+template <typename species_t>
+requires std::equality_comparable<species_t>
+typename Population<species_t>::species_id_t
+Population<species_t>::get_species_id(species_t const &species) {
+    // Organizmy zwykle dodawane są gatunkami, więc najpierw sprawdzamy
+    // ostatnio dodany.
+    if (!species_ids.empty() && species_list[species_ids.back()] == species) {
+        return species_ids.back();
+    }
+    if constexpr (hashable_species<species_t>) {
+        auto found = species_index.find(species);
+        if (found != species_index.end()) {
+            return found->second;
+        }
+    } else {
+        for (species_id_t id = 0; id < species_list.size(); id++) {
+            if (species_list[id] == species) {
+                return id;
+            }
+        }
+    }
+    if (species_list.size() > UINT32_MAX) {
+        throw std::length_error("Too many species in a population.");
+    }
+    species_id_t id = (species_id_t) species_list.size();
+    species_list.push_back(species);
+    if constexpr (hashable_species<species_t>) {
+        species_index.emplace(species, id);
+    }
+    return id;
+}
+
+template <typename species_t>
+requires std::equality_comparable<species_t>
+void Population<species_t>::push(details::diet_t diet,
+                                 species_id_t species_id, uint64_t vitality) {
+    diets.push_back(diet);
+    species_ids.push_back(species_id);
+    vitalities.push_back(vitality);
+}
+
+template <typename species_t>
+requires std::equality_comparable<species_t>
+void Population<species_t>::reserve(std::size_t capacity) {
+    diets.reserve(capacity);
+    species_ids.reserve(capacity);
+    vitalities.reserve(capacity);
+}
+
+template <typename species_t>
+requires std::equality_comparable<species_t>
+bool Population<species_t>::meet(std::size_t index1, std::size_t index2,
+                                 uint64_t &offspring_vitality) {
+    using details::encounter_kind;
+
+    details::diet_t diet1 = diets[index1], diet2 = diets[index2];
+    encounter_kind kind = details::encounter_table[diet1][diet2];
+    uint64_t vitality1 = vitalities[index1], vitality2 = vitalities[index2];
+
+    // Warunki 2 i 3
+    if (kind == encounter_kind::plants || vitality1 == 0 || vitality2 == 0) {
+        return false;
+    }
+
+    // Warunek 4
+    if (diet1 == diet2 && species_ids[index1] == species_ids[index2]) {
+        offspring_vitality = (vitality1 + vitality2) / 2;
+        return true;
+    }
+
+    details::resolve_encounter(kind, vitality1, vitality2);
+    vitalities[index1] = vitality1;
+    vitalities[index2] = vitality2;
+    return false;
+}
+
+template <typename species_t>
+requires std::equality_comparable<species_t>
+void Population<species_t>::encounter(std::size_t index1,
+                                      std::size_t index2) {
+    uint64_t offspring_vitality;
+    if (meet(index1, index2, offspring_vitality)) {
+        push(diets[index1], species_ids[index1], offspring_vitality);
+    }
+}
+
+// Pary losowane są partiami przed spotkaniami, dzięki czemu procesor może
+// jednocześnie czekać na dane wielu organizmów z pamięci głównej.
+template <typename species_t>
+requires std::equality_comparable<species_t>
+template <typename Generator>
+void Population<species_t>::encounters(std::size_t count,
+                                       Generator &generator) {
+    static_assert(Generator::max() - Generator::min() == UINT64_MAX,
+                  "The generator must return 64 random bits.");
+    constexpr std::size_t batch = 64;
+
+    std::size_t pairs[batch][2];
+    while (count > 0 && size() > 1) {
+        std::size_t current = std::min(count, batch);
+        for (std::size_t i = 0; i < current; i++) {
+            pairs[i][0] = details::scale(generator() - Generator::min(),
+                                         size());
+            pairs[i][1] = details::scale(generator() - Generator::min(),
+                                         size() - 1);
+            pairs[i][1] += pairs[i][1] >= pairs[i][0];
+        }
+        for (std::size_t i = 0; i < current; i++) {
+            encounter(pairs[i][0], pairs[i][1]);
+        }
+        count -= current;
+    }
+}
+
+template <typename species_t>
+requires std::equality_comparable<species_t>
+void Population<species_t>::meet_chunk(
+        std::vector<std::size_t> const &order, std::size_t chunk,
+        std::vector<std::pair<std::size_t, uint64_t>> &offspring) {
+    std::size_t begin = chunk * details::round_chunk;
+    std::size_t end = std::min(begin + details::round_chunk, order.size() / 2);
+    for (std::size_t pair = begin; pair < end; pair++) {
+        uint64_t offspring_vitality;
+        if (meet(order[2 * pair], order[2 * pair + 1], offspring_vitality)) {
+            offspring.emplace_back(order[2 * pair], offspring_vitality);
+        }
+    }
+}
+
+// Pary to kolejne elementy losowej permutacji, więc są rozłączne i wątki
+// zmieniają różne organizmy. Permutacja powstaje algorytmem Fishera-Yatesa
+// na jednym wątku. Kawałki par rozdzielane są między wątki po równo,
+// a wątek, który skończy swoje, podbiera połowę kawałków innego. Potomkowie
+// zbierani są osobno dla każdego kawałka, więc ich kolejność nie zależy od
+// tego, który wątek wykonał który kawałek.
+template <typename species_t>
+requires std::equality_comparable<species_t>
+void Population<species_t>::encounter_round(uint64_t seed,
+                                            unsigned thread_count) {
+    std::vector<std::size_t> order(size());
+    for (std::size_t index = 0; index < order.size(); index++) {
+        std::size_t other = details::scale(
+                details::counter_random(seed, index), index + 1);
+        order[index] = order[other];
+        order[other] = index;
+    }
+
+    std::size_t chunks = (order.size() / 2 + details::round_chunk - 1) /
+                         details::round_chunk;
+    if (chunks > UINT32_MAX) {
+        throw std::length_error("Too many organisms for a round.");
+    }
+    std::vector<std::vector<std::pair<std::size_t, uint64_t>>>
+            offspring(chunks);
+
+    std::size_t threads = thread_count > 0 ? thread_count :
+            std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, chunks / details::min_round_chunks + 1);
+    if (threads == 1) {
+        for (std::size_t chunk = 0; chunk < chunks; chunk++) {
+            meet_chunk(order, chunk, offspring[chunk]);
+        }
+    } else {
+        std::vector<details::chunk_range> ranges(threads);
+        for (std::size_t thread = 0; thread < threads; thread++) {
+            ranges[thread].reset((uint32_t) (chunks * thread / threads),
+                                 (uint32_t) (chunks * (thread + 1) / threads));
+        }
+
+        auto work = [&](std::size_t thread) {
+            while (true) {
+                if (std::optional<uint32_t> chunk = ranges[thread].take()) {
+                    meet_chunk(order, *chunk, offspring[*chunk]);
+                    continue;
+                }
+                bool stolen = false;
+                for (std::size_t step = 1; step < threads && !stolen; step++) {
+                    stolen = ranges[thread].steal(
+                            ranges[(thread + step) % threads]);
+                }
+                if (!stolen) {
+                    return;
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (std::size_t thread = 1; thread < threads; thread++) {
+            workers.emplace_back(work, thread);
+        }
+        work(0);
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    for (auto const &born : offspring) {
+        for (auto [parent, vitality] : born) {
+            push(diets[parent], species_ids[parent], vitality);
+        }
+    }
+}
+
+template <typename species_t>
+requires std::equality_comparable<species_t>
+void Population<species_t>::remove_dead() {
+    std::size_t alive = 0;
+    for (std::size_t index = 0; index < size(); index++) {
+        if (vitalities[index] != 0) {
+            diets[alive] = diets[index];
+            species_ids[alive] = species_ids[index];
+            vitalities[alive] = vitalities[index];
+            alive++;
+        }
+    }
+    diets.resize(alive);
+    species_ids.resize(alive);
+    vitalities.resize(alive);
+}
+
+#endif // POPULATION_H
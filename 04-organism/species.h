@@ -0,0 +1,113 @@
+#ifndef SPECIES_H
+#define SPECIES_H
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include "organism.h"
+
+// Gatunek zapamiętany raz we wspólnej tablicy wszystkich gatunków typu
+// species_t. Species<species_t> to wskaźnik do wpisu w tej tablicy, więc
+// kopiuje się go jak liczbę, a gatunki porównuje jednym porównaniem
+// wskaźników. Organism<Species<species_t>, ...> zajmuje przez to 16 bajtów
+// i jest trywialnie kopiowalny. Wpisy nigdy nie są usuwane.
+//
+// Tablicy nie da się uzupełniać w czasie kompilacji, więc organizmy
+// z takimi gatunkami nie są stałymi wyrażeniami.
+
+template <typename species_t>
+concept hashable_species = std::equality_comparable<species_t> &&
+        requires (species_t const &species) {
+            { std::hash<species_t>{}(species) } ->
+                    std::convertible_to<std::size_t>;
+        };
+
+template <hashable_species species_t>
+class Species {
+    // Wpis tablicy: wartość gatunku i jego numer. Węzły unordered_map nie
+    // zmieniają adresów przy dodawaniu kolejnych.
+    using entry_t = std::pair<species_t const, uint32_t>;
+
+    entry_t const *entry;
+
+    struct table_t {
+        std::mutex mutex;
+        std::unordered_map<species_t, uint32_t> ids;
+    };
+
+    static table_t &get_table() {
+        static table_t table;
+        return table;
+    }
+
+    static entry_t const *intern(species_t const &species);
+
+    public:
+        template <typename T>
+        requires (!std::same_as<std::remove_cvref_t<T>, Species> &&
+                  std::constructible_from<species_t, T &&>)
+        Species(T &&species):
+                entry(intern(species_t(std::forward<T>(species)))) {};
+
+        species_t const &get() const {
+            return entry->first;
+        }
+
+        operator species_t const &() const {
+            return entry->first;
+        }
+
+        // Kolejne liczby od 0 w kolejności zapamiętania gatunków.
+        uint32_t get_id() const {
+            return entry->second;
+        }
+
+        bool operator==(Species const &species) const = default;
+
+        static std::size_t count();
+};
+
+template <hashable_species species_t>
+typename Species<species_t>::entry_t const *
+Species<species_t>::intern(species_t const &species) {
+    table_t &table = get_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    auto found = table.ids.find(species);
+    if (found == table.ids.end()) {
+        if (table.ids.size() > UINT32_MAX) {
+            throw std::length_error("Too many species.");
+        }
+        found = table.ids.emplace(species, (uint32_t) table.ids.size()).first;
+    }
+    return &*found;
+}
+
+template <hashable_species species_t>
+std::size_t Species<species_t>::count() {
+    table_t &table = get_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.ids.size();
+}
+
+// Gatunki są równe wtedy i tylko wtedy, gdy mają ten sam numer, więc
+// skrótem gatunku jest skrót numeru, bez liczenia skrótu wartości.
+template <typename species_t>
+struct std::hash<Species<species_t>> {
+    std::size_t operator()(Species<species_t> const &species) const {
+        return std::hash<uint32_t>{}(species.get_id());
+    }
+};
+
+static_assert(hashable_species<Species<std::string>>);
+static_assert(sizeof(Carnivore<Species<std::string>>) == 16);
+static_assert(std::is_trivially_copyable_v<Omnivore<Species<std::string>>>);
+
+#endif // SPECIES_H